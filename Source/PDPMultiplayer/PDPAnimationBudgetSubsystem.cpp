@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPAnimationBudgetSubsystem.h"
+
+#include "PDPMultiplayer.h"
+#include "PDPSkeletalMeshComponent.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+static int32 GAnimBudgetEnable = 1;
+static FAutoConsoleVariableRef CVarAnimBudgetEnable(
+	TEXT("PDP.AnimBudget.Enable"),
+	GAnimBudgetEnable,
+	TEXT("Lower the animation tick rate of the least significant characters to fit the animation budget. Clients only."),
+	ECVF_Default);
+
+static float GAnimBudgetBudgetMs = 1.0f;
+static FAutoConsoleVariableRef CVarAnimBudgetBudgetMs(
+	TEXT("PDP.AnimBudget.BudgetMs"),
+	GAnimBudgetBudgetMs,
+	TEXT("Game thread milliseconds per frame given to character animation."),
+	ECVF_Default);
+
+static int32 GAnimBudgetMaxTickRate = 8;
+static FAutoConsoleVariableRef CVarAnimBudgetMaxTickRate(
+	TEXT("PDP.AnimBudget.MaxTickRate"),
+	GAnimBudgetMaxTickRate,
+	TEXT("Frames between two animation ticks of the least significant characters."),
+	ECVF_Default);
+
+static float GAnimBudgetFullRateDistance = 3000.0f;
+static FAutoConsoleVariableRef CVarAnimBudgetFullRateDistance(
+	TEXT("PDP.AnimBudget.FullRateDistance"),
+	GAnimBudgetFullRateDistance,
+	TEXT("Distance to the camera beyond which a character never ticks its animation every frame."),
+	ECVF_Default);
+
+void UPDPAnimationBudgetSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UPDPAnimationBudgetSubsystem::OnWorldTickStart);
+}
+
+void UPDPAnimationBudgetSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(TickStartHandle);
+
+	Meshes.Reset();
+	SortedMeshes.Reset();
+
+	Super::Deinitialize();
+}
+
+void UPDPAnimationBudgetSubsystem::RegisterMesh(UPDPSkeletalMeshComponent* Mesh)
+{
+	Meshes.AddUnique(Mesh);
+}
+
+void UPDPAnimationBudgetSubsystem::UnregisterMesh(UPDPSkeletalMeshComponent* Mesh)
+{
+	Meshes.RemoveSwap(Mesh);
+}
+
+void UPDPAnimationBudgetSubsystem::ReportTickTime(double Seconds)
+{
+	FrameTickSeconds += Seconds;
+	++FrameTickCount;
+}
+
+void UPDPAnimationBudgetSubsystem::OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || World->GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	// The ticks of the previous frame feed the estimate used for this one.
+	if (FrameTickCount > 0)
+	{
+		const float FrameAverageMs = static_cast<float>(FrameTickSeconds * 1000.0 / FrameTickCount);
+		AverageTickMs = FMath::Lerp(AverageTickMs, FrameAverageMs, 0.1f);
+	}
+
+	FrameTickSeconds = 0.0;
+	FrameTickCount = 0;
+
+	AllocateBudget(World);
+}
+
+void UPDPAnimationBudgetSubsystem::AllocateBudget(UWorld* World)
+{
+	PDP_SCOPE_CYCLE_COUNTER(STAT_PDP_AnimationBudget, AnimationBudget);
+
+	const APlayerController* PlayerController = World->GetFirstPlayerController();
+	const APawn* LocalPawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+	const FVector CameraLocation = PlayerController && PlayerController->PlayerCameraManager ? PlayerController->PlayerCameraManager->GetCameraLocation() : FVector::ZeroVector;
+
+	SortedMeshes.Reset();
+
+	for (int32 Index = Meshes.Num() - 1; Index >= 0; --Index)
+	{
+		UPDPSkeletalMeshComponent* Mesh = Meshes[Index].Get();
+		if (!Mesh)
+		{
+			Meshes.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		if (!GAnimBudgetEnable)
+		{
+			Mesh->SetAnimationTickRate(1);
+			continue;
+		}
+
+		const float DistanceSquared = FVector::DistSquared(Mesh->GetComponentLocation(), CameraLocation);
+
+		FMeshSignificance& Entry = SortedMeshes.AddDefaulted_GetRef();
+		Entry.Mesh = Mesh;
+		Entry.bFullRateAllowed = DistanceSquared <= FMath::Square(GAnimBudgetFullRateDistance);
+
+		if (LocalPawn && Mesh->GetOwner() == LocalPawn)
+		{
+			Entry.Significance = MAX_flt;
+			Entry.bFullRateAllowed = true;
+		}
+		else
+		{
+			// Off screen characters come after every rendered one.
+			const float Proximity = 1.0f / FMath::Max(DistanceSquared, 1.0f);
+			Entry.Significance = Mesh->WasRecentlyRendered(0.2f) ? 1.0f + Proximity : Proximity;
+		}
+	}
+
+	SortedMeshes.Sort([](const FMeshSignificance& A, const FMeshSignificance& B) { return A.Significance > B.Significance; });
+
+	const int32 MaxTickRate = FMath::Max(GAnimBudgetMaxTickRate, 1);
+	float AllocatedMs = 0.0f;
+
+	// Each mesh takes the highest rate that still fits, rates are powers of two so the ticks spread evenly.
+	for (const FMeshSignificance& Entry : SortedMeshes)
+	{
+		int32 TickRate = Entry.bFullRateAllowed ? 1 : 2;
+		while (TickRate < MaxTickRate && AllocatedMs + AverageTickMs / TickRate > GAnimBudgetBudgetMs)
+		{
+			TickRate *= 2;
+		}
+
+		TickRate = FMath::Min(TickRate, MaxTickRate);
+		AllocatedMs += AverageTickMs / TickRate;
+
+		Entry.Mesh->SetAnimationTickRate(TickRate);
+	}
+}
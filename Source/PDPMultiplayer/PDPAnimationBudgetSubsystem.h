@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PDPAnimationBudgetSubsystem.generated.h"
+
+class UPDPSkeletalMeshComponent;
+
+/**
+ * Client-side animation budget. Every frame the character meshes are sorted by significance, the local
+ * character first, then the rendered ones by distance to the camera, then the ones off screen. Walking that
+ * order, each mesh gets the highest tick rate that still fits PDP.AnimBudget.BudgetMs, given the measured
+ * average cost of a mesh tick; the ones that don't fit tick down to once every PDP.AnimBudget.MaxTickRate
+ * frames. Meshes beyond PDP.AnimBudget.FullRateDistance never tick every frame.
+ *
+ * The cost of a tick is the game thread time of the mesh tick. With parallel animation evaluation the pose is
+ * evaluated on a worker thread and completed later in the frame, that part isn't counted, so the budget caps the
+ * game thread cost rather than the whole animation cost.
+ *
+ * Allocation time shows as Animation Budget in "stat PDP".
+ */
+UCLASS()
+class PDPMULTIPLAYER_API UPDPAnimationBudgetSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void RegisterMesh(UPDPSkeletalMeshComponent* Mesh);
+	void UnregisterMesh(UPDPSkeletalMeshComponent* Mesh);
+
+	/** Called by the meshes after each animation tick. */
+	void ReportTickTime(double Seconds);
+
+private:
+	struct FMeshSignificance
+	{
+		UPDPSkeletalMeshComponent* Mesh = nullptr;
+		/** Higher ticks first. */
+		float Significance = 0.0f;
+		bool bFullRateAllowed = true;
+	};
+
+	void OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void AllocateBudget(UWorld* World);
+
+	TArray<TWeakObjectPtr<UPDPSkeletalMeshComponent>> Meshes;
+
+	/** Kept between frames to sort without allocating. */
+	TArray<FMeshSignificance> SortedMeshes;
+
+	/** Moving average of the cost of one mesh tick, in milliseconds. */
+	float AverageTickMs = 0.05f;
+
+	double FrameTickSeconds = 0.0;
+	int32 FrameTickCount = 0;
+
+	FDelegateHandle TickStartHandle;
+};
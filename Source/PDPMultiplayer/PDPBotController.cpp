@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPBotController.h"
+
+#include "PDPMultiplayerCharacter.h"
+#include "Camera/CameraComponent.h"
+#include "Engine/World.h"
+
+APDPBotController::APDPBotController()
+{
+	// Bots score and show up on the scoreboard like players.
+	bWantsPlayerState = true;
+
+	// Aim owns the control rotation, it must not be reset to the facing of the pawn every frame.
+	bSetControlRotationFromPawnOrientation = false;
+
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+void APDPBotController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	APDPMultiplayerCharacter* Character = Cast<APDPMultiplayerCharacter>(GetPawn());
+	if (!Character || Character->IsDead())
+	{
+		return;
+	}
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (Now >= NextDecisionTime)
+	{
+		NextDecisionTime = Now + DecisionInterval * FMath::FRandRange(0.5f, 1.5f);
+		Decide(Character);
+	}
+
+	// Movement input is consumed every frame, like axis bindings.
+	Character->MoveForward(ForwardInput);
+	Character->MoveRight(RightInput);
+
+	Aim(Character, DeltaSeconds);
+}
+
+void APDPBotController::Decide(APDPMultiplayerCharacter* Character)
+{
+	Target = FindTarget(Character);
+
+	ForwardInput = FMath::FRandRange(-1.0f, 1.0f);
+	RightInput = FMath::FRandRange(-1.0f, 1.0f);
+
+	const float AimErrorDegrees = (1.0f - AimAccuracy) * MaxAimError;
+	AimError = FRotator(FMath::FRandRange(-AimErrorDegrees, AimErrorDegrees), FMath::FRandRange(-AimErrorDegrees, AimErrorDegrees), 0.0f);
+
+	Character->StopJumping();
+	if (FMath::FRand() < JumpChance)
+	{
+		Character->Jump();
+	}
+
+	if (FMath::FRand() < CameraSideChance)
+	{
+		if (FMath::RandBool())
+		{
+			Character->ChangeCameraSideLeft();
+		}
+		else
+		{
+			Character->ChangeCameraSideRight();
+		}
+	}
+}
+
+void APDPBotController::Aim(APDPMultiplayerCharacter* Character, float DeltaSeconds)
+{
+	const APDPMultiplayerCharacter* TargetCharacter = Target.Get();
+	if (!TargetCharacter || TargetCharacter->IsDead())
+	{
+		return;
+	}
+
+	const FVector AimStart = Character->GetFollowCamera()->GetComponentLocation();
+	const FRotator DesiredRotation = (TargetCharacter->GetActorLocation() - AimStart).Rotation() + AimError;
+	const FRotator NewRotation = FMath::RInterpConstantTo(GetControlRotation(), DesiredRotation, DeltaSeconds, AimSpeed);
+	SetControlRotation(NewRotation);
+
+	// Fire once the aim has settled, the weapon cooldown is checked by the shot itself.
+	if (NewRotation.Equals(DesiredRotation, 1.0f) && Character->CanShoot())
+	{
+		Character->Fire();
+	}
+}
+
+APDPMultiplayerCharacter* APDPBotController::FindTarget(const APDPMultiplayerCharacter* Character) const
+{
+	const FVector Location = Character->GetActorLocation();
+
+	TArray<FOverlapResult> Overlaps;
+	GetWorld()->OverlapMultiByObjectType(Overlaps, Location, FQuat::Identity, FCollisionObjectQueryParams(ECollisionChannel::ECC_Pawn), FCollisionShape::MakeSphere(TargetRange));
+
+	APDPMultiplayerCharacter* NearestCharacter = nullptr;
+	float NearestDistanceSquared = FMath::Square(TargetRange);
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		APDPMultiplayerCharacter* OtherCharacter = Cast<APDPMultiplayerCharacter>(Overlap.GetActor());
+		if (!OtherCharacter || OtherCharacter == Character || OtherCharacter->IsDead())
+		{
+			continue;
+		}
+
+		const float DistanceSquared = FVector::DistSquared(Location, OtherCharacter->GetActorLocation());
+		if (DistanceSquared < NearestDistanceSquared)
+		{
+			NearestDistanceSquared = DistanceSquared;
+			NearestCharacter = OtherCharacter;
+		}
+	}
+
+	return NearestCharacter;
+}
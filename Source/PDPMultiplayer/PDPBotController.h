@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "PDPBotController.generated.h"
+
+class APDPMultiplayerCharacter;
+
+/**
+ * Load-testing bot. It drives its character through the same input functions a player uses:
+ * it wanders with MoveForward/MoveRight, jumps, switches the camera side, and aims the control
+ * rotation at the nearest living character before firing through the regular Fire/Server_Shot path.
+ */
+UCLASS(config=Game)
+class PDPMULTIPLAYER_API APDPBotController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	APDPBotController();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** 1 aims at the center of the target, 0 misses by up to MaxAimError degrees. */
+	UPROPERTY(config, EditDefaultsOnly, Category= "Bot", meta=(ClampMin = "0", ClampMax = "1"))
+	float AimAccuracy = 0.5f;
+
+	UPROPERTY(config, EditDefaultsOnly, Category= "Bot", meta=(ClampMin = "0"))
+	float MaxAimError = 10.0f;
+
+	/** Characters further than this are ignored. */
+	UPROPERTY(config, EditDefaultsOnly, Category= "Bot", meta=(ClampMin = "0"))
+	float TargetRange = 5000.0f;
+
+	/** Seconds between two decisions: new target, wander direction, aim error, jump and camera side. */
+	UPROPERTY(config, EditDefaultsOnly, Category= "Bot", meta=(ClampMin = "0"))
+	float DecisionInterval = 0.5f;
+
+	/** Degrees per second the aim turns towards the target. */
+	UPROPERTY(config, EditDefaultsOnly, Category= "Bot", meta=(ClampMin = "0"))
+	float AimSpeed = 360.0f;
+
+	UPROPERTY(config, EditDefaultsOnly, Category= "Bot", meta=(ClampMin = "0", ClampMax = "1"))
+	float JumpChance = 0.1f;
+
+	UPROPERTY(config, EditDefaultsOnly, Category= "Bot", meta=(ClampMin = "0", ClampMax = "1"))
+	float CameraSideChance = 0.05f;
+
+private:
+	void Decide(APDPMultiplayerCharacter* Character);
+	void Aim(APDPMultiplayerCharacter* Character, float DeltaSeconds);
+
+	APDPMultiplayerCharacter* FindTarget(const APDPMultiplayerCharacter* Character) const;
+
+	TWeakObjectPtr<APDPMultiplayerCharacter> Target;
+
+	FRotator AimError = FRotator::ZeroRotator;
+	float ForwardInput = 0.0f;
+	float RightInput = 0.0f;
+	float NextDecisionTime = 0.0f;
+};
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPCharacterState.h"
+
+bool FPDPCharacterState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 NetHealth = 0;
+	uint8 Flags = 0;
+
+	if (Ar.IsSaving())
+	{
+		// Round up so a character that is still alive is never sent with zero health.
+		NetHealth = static_cast<uint32>(FMath::Clamp(FMath::CeilToInt(Health), 0, MaxNetHealth));
+		Flags = (bLeftShoulder ? 1 : 0) | (bDead ? 2 : 0);
+	}
+
+	Ar.SerializeBits(&NetHealth, HealthBits);
+	Ar << Ammo;
+	Ar.SerializeBits(&Flags, FlagBits);
+
+	if (Ar.IsLoading())
+	{
+		Health = static_cast<float>(NetHealth);
+		bLeftShoulder = (Flags & 1) != 0;
+		bDead = (Flags & 2) != 0;
+	}
+
+	bOutSuccess = true;
+	return true;
+}
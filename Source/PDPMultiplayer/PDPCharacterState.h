@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PDPCharacterState.generated.h"
+
+/**
+ * Replicated gameplay state of a character, bit-packed by NetSerialize:
+ * health as a whole number of points, ammo, shoulder side and dead flag.
+ */
+USTRUCT()
+struct PDPMULTIPLAYER_API FPDPCharacterState
+{
+	GENERATED_BODY()
+
+	/** Number of bits health is quantized to. */
+	static constexpr uint32 HealthBits = 10;
+	static constexpr int32 MaxNetHealth = (1 << HealthBits) - 1;
+
+	static constexpr uint32 FlagBits = 2;
+
+	/** Bits written by NetSerialize, the same for every state. */
+	static constexpr uint32 NetBits = HealthBits + 8 + FlagBits;
+
+	UPROPERTY()
+	float Health = 0.0f;
+
+	UPROPERTY()
+	uint8 Ammo = 0;
+
+	UPROPERTY()
+	bool bLeftShoulder = false;
+
+	UPROPERTY()
+	bool bDead = false;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FPDPCharacterState> : public TStructOpsTypeTraitsBase2<FPDPCharacterState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPCorpseSubsystem.h"
+
+#include "PDPMultiplayer.h"
+#include "PDPMultiplayerCharacter.h"
+#include "PDPMultiplayerGameMode.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "TimerManager.h"
+
+void UPDPCorpseSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(UpdateTimerHandle);
+	}
+
+	Corpses.Reset();
+	NumSimulating = 0;
+
+	Super::Deinitialize();
+}
+
+void UPDPCorpseSubsystem::AddCorpse(APDPMultiplayerCharacter* Character)
+{
+	UWorld* World = GetWorld();
+	if (!World || !Character)
+	{
+		return;
+	}
+
+	RemoveCorpse(Character);
+
+	FCorpse& Corpse = Corpses.AddDefaulted_GetRef();
+	Corpse.Character = Character;
+	Corpse.DeathTime = World->GetTimeSeconds();
+	++NumSimulating;
+
+	// Nobody looks at the ragdolls of a dedicated server, and hits ignore corpses.
+	if (World->GetNetMode() == NM_DedicatedServer)
+	{
+		FreezeCorpse(Corpse);
+	}
+
+	// Make room in the simulation budget, oldest ragdoll first.
+	for (FCorpse& OldCorpse : Corpses)
+	{
+		if (NumSimulating <= MaxSimulatedRagdolls)
+		{
+			break;
+		}
+
+		FreezeCorpse(OldCorpse);
+	}
+
+	// Started lazily, the game instance owning the timer manager may not exist when the subsystem is created.
+	if (!World->GetTimerManager().IsTimerActive(UpdateTimerHandle))
+	{
+		World->GetTimerManager().SetTimer(UpdateTimerHandle, this, &UPDPCorpseSubsystem::UpdateCorpses, UpdateInterval, true);
+	}
+}
+
+void UPDPCorpseSubsystem::RemoveCorpse(APDPMultiplayerCharacter* Character)
+{
+	const int32 Index = Corpses.IndexOfByPredicate([Character](const FCorpse& Corpse) { return Corpse.Character == Character; });
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (Corpses[Index].bSimulating)
+	{
+		--NumSimulating;
+	}
+
+	Corpses.RemoveAt(Index);
+}
+
+void UPDPCorpseSubsystem::FreezeCorpse(FCorpse& Corpse)
+{
+	if (!Corpse.bSimulating)
+	{
+		return;
+	}
+
+	Corpse.bSimulating = false;
+	--NumSimulating;
+
+	if (APDPMultiplayerCharacter* Character = Corpse.Character.Get())
+	{
+		Character->FreezeRagdoll();
+	}
+}
+
+void UPDPCorpseSubsystem::EvictCorpse(FCorpse& Corpse)
+{
+	FreezeCorpse(Corpse);
+
+	APDPMultiplayerCharacter* Character = Corpse.Character.Get();
+	Corpse.Character.Reset();
+
+	UWorld* World = GetWorld();
+	if (!Character || !World)
+	{
+		return;
+	}
+
+	// Clients follow the server, the pooled character is hidden through replication.
+	if (APDPMultiplayerGameMode* GameMode = World->GetAuthGameMode<APDPMultiplayerGameMode>())
+	{
+		GameMode->ReleasePawn(Character);
+	}
+}
+
+void UPDPCorpseSubsystem::UpdateCorpses()
+{
+	PDP_SCOPE_CYCLE_COUNTER(STAT_PDP_UpdateCorpses, UpdateCorpses);
+
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	const float Now = World->GetTimeSeconds();
+	const bool bHasAuthority = World->GetAuthGameMode() != nullptr;
+
+	FVector ViewLocation = FVector::ZeroVector;
+	const APlayerController* PlayerController = World->GetFirstPlayerController();
+	const bool bHasViewer = PlayerController && PlayerController->PlayerCameraManager;
+	if (bHasViewer)
+	{
+		ViewLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+	}
+
+	int32 NumToEvict = bHasAuthority ? FMath::Max(Corpses.Num() - MaxCorpses, 0) : 0;
+
+	for (int32 Index = 0; Index < Corpses.Num(); ++Index)
+	{
+		FCorpse& Corpse = Corpses[Index];
+
+		const APDPMultiplayerCharacter* Character = Corpse.Character.Get();
+		if (!Character)
+		{
+			continue;
+		}
+
+		// A victim keeps its corpse, under its camera and kill-cam, until the respawn unpossesses it.
+		// The budget then goes to the next oldest corpse instead.
+		const float Age = Now - Corpse.DeathTime;
+		if (bHasAuthority && !Character->GetController() && (NumToEvict > 0 || Age > CorpseLifeSpan))
+		{
+			NumToEvict = FMath::Max(NumToEvict - 1, 0);
+			EvictCorpse(Corpse);
+			continue;
+		}
+
+		if (!Corpse.bSimulating)
+		{
+			continue;
+		}
+
+		const USkeletalMeshComponent* CharacterMesh = Character->GetMesh();
+		const bool bIsNear = bHasViewer && FVector::DistSquared(ViewLocation, CharacterMesh->GetComponentLocation()) <= FMath::Square(SimulationDistance);
+		const float SimulationTime = bIsNear ? MaxSimulationTime : FarSimulationTime;
+
+		if (!CharacterMesh->RigidBodyIsAwake() || Age > SimulationTime)
+		{
+			FreezeCorpse(Corpse);
+		}
+	}
+
+	Corpses.RemoveAll([](const FCorpse& Corpse)
+	{
+		return !Corpse.Character.IsValid();
+	});
+
+	// Corpses that vanished without being frozen must give their simulation slot back.
+	NumSimulating = 0;
+	for (const FCorpse& Corpse : Corpses)
+	{
+		NumSimulating += Corpse.bSimulating ? 1 : 0;
+	}
+
+	SET_DWORD_STAT(STAT_PDP_Corpses, Corpses.Num());
+
+	if (Corpses.Num() == 0)
+	{
+		World->GetTimerManager().ClearTimer(UpdateTimerHandle);
+	}
+}
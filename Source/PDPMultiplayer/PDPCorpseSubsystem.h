@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PDPCorpseSubsystem.generated.h"
+
+class APDPMultiplayerCharacter;
+
+/**
+ * Keeps ragdoll physics cost flat no matter how many kills happen. Only a few ragdolls simulate at
+ * the same time, and only until they settle; after that their pose is frozen. Corpses over the budget
+ * or past their life span are evicted oldest first and, on the server, go back to the pawn pool.
+ */
+UCLASS(config=Game)
+class PDPMULTIPLAYER_API UPDPCorpseSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	void AddCorpse(APDPMultiplayerCharacter* Character);
+	void RemoveCorpse(APDPMultiplayerCharacter* Character);
+
+	/** Number of ragdolls allowed to simulate at the same time. */
+	UPROPERTY(config)
+	int32 MaxSimulatedRagdolls = 6;
+
+	/** Number of corpses kept in the world by the server. */
+	UPROPERTY(config)
+	int32 MaxCorpses = 16;
+
+	/** Seconds a corpse stays in the world before the server evicts it. */
+	UPROPERTY(config)
+	float CorpseLifeSpan = 30.0f;
+
+	/** Seconds a ragdoll close to the viewer may simulate before it is frozen even if it hasn't settled. */
+	UPROPERTY(config)
+	float MaxSimulationTime = 5.0f;
+
+	/** Ragdolls further than this from the viewer only simulate for FarSimulationTime. */
+	UPROPERTY(config)
+	float SimulationDistance = 3000.0f;
+
+	/** Seconds a ragdoll far from the viewer may simulate. */
+	UPROPERTY(config)
+	float FarSimulationTime = 1.0f;
+
+	/** Seconds between two updates of the corpses. */
+	UPROPERTY(config)
+	float UpdateInterval = 0.25f;
+
+private:
+	struct FCorpse
+	{
+		TWeakObjectPtr<APDPMultiplayerCharacter> Character;
+		float DeathTime = 0.0f;
+		bool bSimulating = true;
+	};
+
+	void UpdateCorpses();
+	void FreezeCorpse(FCorpse& Corpse);
+	void EvictCorpse(FCorpse& Corpse);
+
+	/** Oldest corpse first. */
+	TArray<FCorpse> Corpses;
+
+	int32 NumSimulating = 0;
+
+	FTimerHandle UpdateTimerHandle;
+};
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPDamageSubsystem.h"
+
+#include "PDPMultiplayer.h"
+#include "PDPMultiplayerCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+
+void UPDPDamageSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UPDPDamageSubsystem::OnWorldPostActorTick);
+}
+
+void UPDPDamageSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	PendingDamage.Reset();
+
+	Super::Deinitialize();
+}
+
+void UPDPDamageSubsystem::QueueDamage(APDPMultiplayerCharacter* Target, float Damage, AController* InstigatedBy)
+{
+	if (!Target || Damage <= 0.0f)
+	{
+		return;
+	}
+
+	FDamageRecord& Record = PendingDamage.AddDefaulted_GetRef();
+	Record.Target = Target;
+	Record.InstigatedBy = InstigatedBy;
+	Record.Damage = Damage;
+}
+
+void UPDPDamageSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || PendingDamage.Num() == 0)
+	{
+		return;
+	}
+
+	ResolveDamage();
+}
+
+void UPDPDamageSubsystem::ResolveDamage()
+{
+	PDP_SCOPE_CYCLE_COUNTER(STAT_PDP_ResolveDamage, ResolveDamage);
+
+	Targets.Reset();
+	Deaths.Reset();
+
+	// Hits are walked in the order they were confirmed, so the killer is always the one whose hit
+	// brought health to zero and the hits landing after it are dropped.
+	for (const FDamageRecord& Record : PendingDamage)
+	{
+		APDPMultiplayerCharacter* Target = Record.Target.Get();
+		if (!Target || Target->IsDead())
+		{
+			continue;
+		}
+
+		int32 TargetIndex = Targets.IndexOfByPredicate([Target](const FTargetDamage& TargetDamage) { return TargetDamage.Target == Target; });
+		if (TargetIndex == INDEX_NONE)
+		{
+			TargetIndex = Targets.AddDefaulted();
+			Targets[TargetIndex].Target = Target;
+		}
+
+		FTargetDamage& TargetDamage = Targets[TargetIndex];
+		if (TargetDamage.bKilled)
+		{
+			continue;
+		}
+
+		TargetDamage.Damage += Record.Damage;
+
+		if (Target->GetHealth() - TargetDamage.Damage <= 0.0f)
+		{
+			TargetDamage.bKilled = true;
+			TargetDamage.Killer = Record.InstigatedBy.Get();
+			Deaths.Add(TargetIndex);
+		}
+	}
+
+	PendingDamage.Reset();
+
+	// Everyone who was hit this frame takes their damage before anyone dies, so two players
+	// killing each other in the same frame both die whatever the order of their targets.
+	for (const FTargetDamage& TargetDamage : Targets)
+	{
+		TargetDamage.Target->ApplyResolvedDamage(TargetDamage.Damage);
+	}
+
+	for (const int32 TargetIndex : Deaths)
+	{
+		const FTargetDamage& TargetDamage = Targets[TargetIndex];
+		TargetDamage.Target->Die(TargetDamage.Killer);
+	}
+}
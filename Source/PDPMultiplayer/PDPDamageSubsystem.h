@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PDPDamageSubsystem.generated.h"
+
+class AController;
+class APDPMultiplayerCharacter;
+
+/**
+ * Server-side damage queue. Hits are recorded as they are confirmed and resolved once per tick,
+ * after the actors have ticked: the hits on a target are summed into a single health change, and
+ * the deaths of the frame are emitted together once all damage has been applied.
+ */
+UCLASS()
+class PDPMULTIPLAYER_API UPDPDamageSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void QueueDamage(APDPMultiplayerCharacter* Target, float Damage, AController* InstigatedBy);
+
+private:
+	struct FDamageRecord
+	{
+		TWeakObjectPtr<APDPMultiplayerCharacter> Target;
+		TWeakObjectPtr<AController> InstigatedBy;
+		float Damage = 0.0f;
+	};
+
+	struct FTargetDamage
+	{
+		APDPMultiplayerCharacter* Target = nullptr;
+		AController* Killer = nullptr;
+		float Damage = 0.0f;
+		bool bKilled = false;
+	};
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void ResolveDamage();
+
+	/** Hits of the current frame, in the order they were confirmed. */
+	TArray<FDamageRecord> PendingDamage;
+
+	/** Scratch arrays of ResolveDamage, kept to reuse their allocations. */
+	TArray<FTargetDamage> Targets;
+	TArray<int32> Deaths;
+
+	FDelegateHandle PostActorTickHandle;
+};
@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPGameState.h"
+
+#include "Net/UnrealNetwork.h"
+
+APDPGameState::APDPGameState()
+{
+	Scoreboard.Owner = this;
+}
+
+void APDPGameState::NotifyScoreboardEntryChanged(const FPDPScoreboardEntry& Entry)
+{
+	OnScoreboardEntryChanged.Broadcast(Entry);
+}
+
+void APDPGameState::NotifyScoreboardEntryRemoved(const FPDPScoreboardEntry& Entry)
+{
+	OnScoreboardEntryRemoved.Broadcast(Entry.PlayerState);
+}
+
+void APDPGameState::GetLifetimeReplicatedProps(TArray< FLifetimeProperty > & OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(APDPGameState, Scoreboard);
+}
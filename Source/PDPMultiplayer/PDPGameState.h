@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameStateBase.h"
+#include "PDPScoreboard.h"
+#include "PDPGameState.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FPDPOnScoreboardEntryChanged, const FPDPScoreboardEntry&, Entry);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FPDPOnScoreboardEntryRemoved, APlayerState*, PlayerState);
+
+/**
+ * Holds the scoreboard of the match. Rows are set by the player states on the server and replicated one by one,
+ * the scoreboard widget updates the row it is told about instead of rebuilding the board.
+ */
+UCLASS()
+class PDPMULTIPLAYER_API APDPGameState : public AGameStateBase
+{
+	GENERATED_BODY()
+
+public:
+	APDPGameState();
+
+	FORCEINLINE FPDPScoreboard& GetScoreboard() { return Scoreboard; }
+
+	UFUNCTION(BlueprintPure, Category= "Scoreboard")
+	const TArray<FPDPScoreboardEntry>& GetScoreboardEntries() const { return Scoreboard.GetEntries(); }
+
+	void NotifyScoreboardEntryChanged(const FPDPScoreboardEntry& Entry);
+	void NotifyScoreboardEntryRemoved(const FPDPScoreboardEntry& Entry);
+
+	/** A row was added or changed. */
+	UPROPERTY(BlueprintAssignable, Category= "Scoreboard")
+	FPDPOnScoreboardEntryChanged OnScoreboardEntryChanged;
+
+	UPROPERTY(BlueprintAssignable, Category= "Scoreboard")
+	FPDPOnScoreboardEntryRemoved OnScoreboardEntryRemoved;
+
+private:
+	UPROPERTY(Replicated)
+	FPDPScoreboard Scoreboard;
+};
@@ -0,0 +1,292 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPLagCompensationSubsystem.h"
+
+#include "PDPMultiplayer.h"
+#include "PDPMultiplayerCharacter.h"
+#include "PDPReplaySubsystem.h"
+#include "PDPShotTraceSubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static float GLagCompensationHistoryLength = 1.0f;
+static FAutoConsoleVariableRef CVarLagCompensationHistoryLength(
+	TEXT("PDP.LagCompensation.HistoryLength"),
+	GLagCompensationHistoryLength,
+	TEXT("Seconds of character hitbox history kept by the server for lag compensation."),
+	ECVF_Default);
+
+static float GLagCompensationMaxRewind = 0.3f;
+static FAutoConsoleVariableRef CVarLagCompensationMaxRewind(
+	TEXT("PDP.LagCompensation.MaxRewind"),
+	GLagCompensationMaxRewind,
+	TEXT("Maximum number of seconds a shot may rewind targets. Older client timestamps are clamped to this window."),
+	ECVF_Default);
+
+void UPDPLagCompensationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UPDPLagCompensationSubsystem::OnWorldPostActorTick);
+	TickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UPDPLagCompensationSubsystem::OnWorldTickStart);
+
+	OcclusionTraceDelegate.BindUObject(this, &UPDPLagCompensationSubsystem::OnOcclusionTraceDone);
+}
+
+void UPDPLagCompensationSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	FWorldDelegates::OnWorldTickStart.Remove(TickStartHandle);
+	OcclusionTraceDelegate.Unbind();
+	Histories.Reset();
+	PendingHits.Reset();
+
+	Super::Deinitialize();
+}
+
+void UPDPLagCompensationSubsystem::RegisterCharacter(APDPMultiplayerCharacter* Character)
+{
+	if (!Character || Histories.ContainsByPredicate([Character](const FCharacterHistory& History) { return History.Character == Character; }))
+	{
+		return;
+	}
+
+	FCharacterHistory& History = Histories.AddDefaulted_GetRef();
+	History.Character = Character;
+}
+
+void UPDPLagCompensationSubsystem::UnregisterCharacter(APDPMultiplayerCharacter* Character)
+{
+	Histories.RemoveAllSwap([Character](const FCharacterHistory& History) { return History.Character == Character; });
+}
+
+void UPDPLagCompensationSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || Histories.Num() == 0)
+	{
+		return;
+	}
+
+	PDP_SCOPE_CYCLE_COUNTER(STAT_PDP_RecordHitboxes, RecordHitboxes);
+
+	const float Now = World->GetTimeSeconds();
+	const float OldestTime = Now - GLagCompensationHistoryLength;
+
+	for (int32 Index = Histories.Num() - 1; Index >= 0; --Index)
+	{
+		FCharacterHistory& History = Histories[Index];
+
+		const APDPMultiplayerCharacter* Character = History.Character.Get();
+		if (!IsValid(Character))
+		{
+			Histories.RemoveAtSwap(Index);
+			continue;
+		}
+
+		const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+		if (!IsValid(Capsule))
+		{
+			continue;
+		}
+
+		// Drop expired entries but always keep one to interpolate from.
+		int32 NumExpired = 0;
+		while (NumExpired < History.Snapshots.Num() - 1 && History.Snapshots[NumExpired + 1].Time <= OldestTime)
+		{
+			++NumExpired;
+		}
+		History.Snapshots.RemoveAt(0, NumExpired, false);
+
+		FPDPHitboxSnapshot& Snapshot = History.Snapshots.AddDefaulted_GetRef();
+		Snapshot.Time = Now;
+		Snapshot.Location = Capsule->GetComponentLocation();
+		Snapshot.Rotation = Capsule->GetComponentQuat();
+		Snapshot.CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+		Snapshot.CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+	}
+}
+
+bool UPDPLagCompensationSubsystem::GetSnapshotAtTime(const FCharacterHistory& History, float Time, FPDPHitboxSnapshot& OutSnapshot)
+{
+	const TArray<FPDPHitboxSnapshot>& Snapshots = History.Snapshots;
+	if (Snapshots.Num() == 0)
+	{
+		return false;
+	}
+
+	if (Time <= Snapshots[0].Time)
+	{
+		OutSnapshot = Snapshots[0];
+		return true;
+	}
+
+	for (int32 Index = 1; Index < Snapshots.Num(); ++Index)
+	{
+		const FPDPHitboxSnapshot& Newer = Snapshots[Index];
+		if (Newer.Time < Time)
+		{
+			continue;
+		}
+
+		const FPDPHitboxSnapshot& Older = Snapshots[Index - 1];
+		const float Alpha = FMath::GetRangePct(Older.Time, Newer.Time, Time);
+
+		OutSnapshot.Time = Time;
+		OutSnapshot.Location = FMath::Lerp(Older.Location, Newer.Location, Alpha);
+		OutSnapshot.Rotation = FQuat::Slerp(Older.Rotation, Newer.Rotation, Alpha);
+		OutSnapshot.CapsuleRadius = FMath::Lerp(Older.CapsuleRadius, Newer.CapsuleRadius, Alpha);
+		OutSnapshot.CapsuleHalfHeight = FMath::Lerp(Older.CapsuleHalfHeight, Newer.CapsuleHalfHeight, Alpha);
+		return true;
+	}
+
+	OutSnapshot = Snapshots.Last();
+	return true;
+}
+
+void UPDPLagCompensationSubsystem::QueueShot(APDPMultiplayerCharacter* Shooter, const FVector& TraceStart, const FVector& TraceEnd, float ClientTime, float Damage, uint16 ShotId)
+{
+	PDP_SCOPE_CYCLE_COUNTER(STAT_PDP_ConfirmHit, ConfirmHit);
+
+	UWorld* World = GetWorld();
+	if (!World || !Shooter)
+	{
+		return;
+	}
+
+	FVector HitLocation = TraceEnd;
+	FCollisionQueryParams OcclusionParams(SCENE_QUERY_STAT(PDPShotOcclusion));
+	APDPMultiplayerCharacter* Target = RewindTrace(Shooter, TraceStart, TraceEnd, ClientTime, HitLocation, OcclusionParams);
+	if (!Target)
+	{
+		RecordShotTrace(Shooter, ShotId, TraceStart, TraceEnd, nullptr, TraceEnd);
+		return;
+	}
+
+	FPendingHit& Hit = PendingHits.AddDefaulted_GetRef();
+	Hit.Shooter = Shooter;
+	Hit.InstigatedBy = Shooter->GetController();
+	Hit.Target = Target;
+	Hit.TraceStart = TraceStart;
+	Hit.TraceEnd = TraceEnd;
+	Hit.HitLocation = HitLocation;
+	Hit.Damage = Damage;
+	Hit.ShotId = ShotId;
+
+	// The trace runs on a worker thread next to the rest of the frame, the game thread never waits for it.
+	Hit.TraceHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, TraceStart, HitLocation, ECollisionChannel::ECC_Visibility, OcclusionParams, FCollisionResponseParams::DefaultResponseParam, &OcclusionTraceDelegate);
+}
+
+APDPMultiplayerCharacter* UPDPLagCompensationSubsystem::RewindTrace(const APDPMultiplayerCharacter* Shooter, const FVector& TraceStart, const FVector& TraceEnd, float ClientTime, FVector& OutHitLocation, FCollisionQueryParams& OutOcclusionParams) const
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float RewindWindow = FMath::Min(GLagCompensationMaxRewind, GLagCompensationHistoryLength);
+	const float RewindTime = FMath::Clamp(ClientTime, Now - RewindWindow, Now);
+
+	OutOcclusionParams.AddIgnoredActor(Shooter);
+
+	APDPMultiplayerCharacter* ClosestCharacter = nullptr;
+	float ClosestDistanceSquared = TNumericLimits<float>::Max();
+
+	for (const FCharacterHistory& History : Histories)
+	{
+		APDPMultiplayerCharacter* Character = History.Character.Get();
+		if (!Character)
+		{
+			continue;
+		}
+
+		// Characters never block the world occlusion test, only their rewound capsules count.
+		OutOcclusionParams.AddIgnoredActor(Character);
+
+		// Corpses and pooled characters keep their capsule but can't be hit.
+		FPDPHitboxSnapshot Snapshot;
+		if (Character == Shooter || Character->IsDead() || Character->IsHidden() || !GetSnapshotAtTime(History, RewindTime, Snapshot))
+		{
+			continue;
+		}
+
+		const FVector CapsuleAxis = Snapshot.Rotation.GetUpVector() * FMath::Max(Snapshot.CapsuleHalfHeight - Snapshot.CapsuleRadius, 0.0f);
+
+		FVector PointOnTrace;
+		FVector PointOnAxis;
+		FMath::SegmentDistToSegmentSafe(TraceStart, TraceEnd, Snapshot.Location - CapsuleAxis, Snapshot.Location + CapsuleAxis, PointOnTrace, PointOnAxis);
+
+		if (FVector::DistSquared(PointOnTrace, PointOnAxis) > FMath::Square(Snapshot.CapsuleRadius))
+		{
+			continue;
+		}
+
+		const float DistanceSquared = FVector::DistSquared(TraceStart, PointOnTrace);
+		if (DistanceSquared < ClosestDistanceSquared)
+		{
+			ClosestDistanceSquared = DistanceSquared;
+			OutHitLocation = PointOnTrace;
+			ClosestCharacter = Character;
+		}
+	}
+
+	return ClosestCharacter;
+}
+
+void UPDPLagCompensationSubsystem::OnOcclusionTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	FPendingHit* Hit = PendingHits.FindByPredicate([&TraceHandle](const FPendingHit& PendingHit) { return PendingHit.TraceHandle == TraceHandle; });
+	if (!Hit)
+	{
+		return;
+	}
+
+	Hit->bTraceDone = true;
+	Hit->bOccluded = TraceDatum.OutHits.Num() > 0 && TraceDatum.OutHits[0].bBlockingHit;
+}
+
+void UPDPLagCompensationSubsystem::OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || PendingHits.Num() == 0)
+	{
+		return;
+	}
+
+	ConfirmHits();
+}
+
+void UPDPLagCompensationSubsystem::ConfirmHits()
+{
+	// Hits are confirmed in the order the shots were received, so the damage subsystem credits the right killer.
+	int32 NumConfirmed = 0;
+	while (NumConfirmed < PendingHits.Num() && PendingHits[NumConfirmed].bTraceDone)
+	{
+		const FPendingHit& Hit = PendingHits[NumConfirmed++];
+
+		APDPMultiplayerCharacter* Target = Hit.Target.Get();
+		const bool bHit = Target && !Hit.bOccluded;
+
+		RecordShotTrace(Hit.Shooter.Get(), Hit.ShotId, Hit.TraceStart, Hit.TraceEnd, bHit ? Target : nullptr, Hit.HitLocation);
+
+		if (bHit)
+		{
+			PDP_INC_COUNTER(STAT_PDP_Hits, Hits, 1);
+			Target->TakeDamage(Hit.Damage, FDamageEvent(), Hit.InstigatedBy.Get(), nullptr);
+		}
+	}
+
+	PendingHits.RemoveAt(0, NumConfirmed, false);
+}
+
+void UPDPLagCompensationSubsystem::RecordShotTrace(const APDPMultiplayerCharacter* Shooter, uint16 ShotId, const FVector& TraceStart, const FVector& TraceEnd, const APDPMultiplayerCharacter* Target, const FVector& HitLocation) const
+{
+	if (UPDPReplaySubsystem* Replay = GetWorld()->GetSubsystem<UPDPReplaySubsystem>())
+	{
+		Replay->RecordShot(Shooter, TraceStart, Target ? HitLocation : TraceEnd, Target);
+	}
+
+#if !UE_BUILD_SHIPPING
+	UPDPShotTraceSubsystem* ShotTraces = GetWorld()->GetSubsystem<UPDPShotTraceSubsystem>();
+	if (ShotTraces && UPDPShotTraceSubsystem::IsEnabled())
+	{
+		ShotTraces->RecordTrace(Shooter, ShotId, TraceStart, TraceEnd, Target, HitLocation);
+	}
+#endif
+}
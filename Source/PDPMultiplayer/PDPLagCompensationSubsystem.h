@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/World.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PDPLagCompensationSubsystem.generated.h"
+
+class AController;
+class APDPMultiplayerCharacter;
+
+/** Capsule pose of a character at a given server time. */
+struct FPDPHitboxSnapshot
+{
+	float Time = 0.0f;
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	float CapsuleRadius = 0.0f;
+	float CapsuleHalfHeight = 0.0f;
+};
+
+/**
+ * Server-side hitbox history of every character. Shots are resolved against the poses
+ * the shooter saw at its client timestamp, so a single fire message is enough to confirm a hit.
+ *
+ * The world occlusion test of a hit runs as an async trace, alongside the rest of the frame. Hits are
+ * confirmed at the start of the frame following its completion and their damage resolved in one batch.
+ */
+UCLASS()
+class PDPMULTIPLAYER_API UPDPLagCompensationSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void RegisterCharacter(APDPMultiplayerCharacter* Character);
+	void UnregisterCharacter(APDPMultiplayerCharacter* Character);
+
+	/**
+	 * Rewinds every character but the shooter to ClientTime and traces against their capsules. The closest
+	 * character hit is confirmed once the async trace finds no world geometry in front of it, and Damage is
+	 * then applied to it.
+	 * @param ShotId	Sequence id of the shot, for the shot trace view
+	 */
+	void QueueShot(APDPMultiplayerCharacter* Shooter, const FVector& TraceStart, const FVector& TraceEnd, float ClientTime, float Damage, uint16 ShotId);
+
+private:
+	struct FPendingHit
+	{
+		TWeakObjectPtr<APDPMultiplayerCharacter> Shooter;
+		TWeakObjectPtr<AController> InstigatedBy;
+		TWeakObjectPtr<APDPMultiplayerCharacter> Target;
+		FVector TraceStart = FVector::ZeroVector;
+		FVector TraceEnd = FVector::ZeroVector;
+		FVector HitLocation = FVector::ZeroVector;
+		float Damage = 0.0f;
+		uint16 ShotId = 0;
+		FTraceHandle TraceHandle;
+		bool bTraceDone = false;
+		bool bOccluded = false;
+	};
+
+	struct FCharacterHistory
+	{
+		TWeakObjectPtr<APDPMultiplayerCharacter> Character;
+		TArray<FPDPHitboxSnapshot> Snapshots;
+	};
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+	void OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	/**
+	 * @param OutHitLocation	Where the trace enters the rewound capsule of the character hit
+	 * @param OutOcclusionParams	Query params of the occlusion test, ignoring every character
+	 * @return The closest character whose rewound capsule is on the trace, or nullptr.
+	 */
+	APDPMultiplayerCharacter* RewindTrace(const APDPMultiplayerCharacter* Shooter, const FVector& TraceStart, const FVector& TraceEnd, float ClientTime, FVector& OutHitLocation, FCollisionQueryParams& OutOcclusionParams) const;
+
+	void OnOcclusionTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	/** Applies the damage of the hits whose occlusion test is done and not blocked. */
+	void ConfirmHits();
+
+	void RecordShotTrace(const APDPMultiplayerCharacter* Shooter, uint16 ShotId, const FVector& TraceStart, const FVector& TraceEnd, const APDPMultiplayerCharacter* Target, const FVector& HitLocation) const;
+
+	static bool GetSnapshotAtTime(const FCharacterHistory& History, float Time, FPDPHitboxSnapshot& OutSnapshot);
+
+	TArray<FCharacterHistory> Histories;
+
+	/** Hits waiting for their occlusion test, in the order the shots were received. */
+	TArray<FPendingHit> PendingHits;
+
+	FTraceDelegate OcclusionTraceDelegate;
+
+	FDelegateHandle PostActorTickHandle;
+	FDelegateHandle TickStartHandle;
+};
@@ -0,0 +1,213 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPLoadTestSubsystem.h"
+
+#include "PDPMultiplayer.h"
+#include "PDPMultiplayerGameMode.h"
+#include "PDPReplicationGraph.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static FAutoConsoleCommandWithWorldAndArgs SpawnBotsCommand(
+	TEXT("PDP.Bots.Spawn"),
+	TEXT("Adds N load-testing bots to the match. Server only. Usage: PDP.Bots.Spawn <N>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		APDPMultiplayerGameMode* GameMode = World ? World->GetAuthGameMode<APDPMultiplayerGameMode>() : nullptr;
+		if (!GameMode || Args.Num() == 0)
+		{
+			return;
+		}
+
+		GameMode->SpawnBots(FCString::Atoi(*Args[0]));
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs LoadTestCommand(
+	TEXT("PDP.LoadTest"),
+	TEXT("Runs the server load test, doubling the number of bots at every step. Usage: PDP.LoadTest [MinBots] [MaxBots]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UPDPLoadTestSubsystem* LoadTest = World ? World->GetSubsystem<UPDPLoadTestSubsystem>() : nullptr;
+		if (!LoadTest)
+		{
+			return;
+		}
+
+		if (Args.Num() > 0)
+		{
+			LoadTest->MinBots = FCString::Atoi(*Args[0]);
+		}
+
+		if (Args.Num() > 1)
+		{
+			LoadTest->MaxBots = FCString::Atoi(*Args[1]);
+		}
+
+		LoadTest->StartLoadTest(false);
+	}));
+
+static float GetPercentile(const TArray<float>& SortedValues, float Percentile)
+{
+	if (SortedValues.Num() == 0)
+	{
+		return 0.0f;
+	}
+
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * SortedValues.Num()) - 1, 0, SortedValues.Num() - 1);
+	return SortedValues[Index];
+}
+
+void UPDPLoadTestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UPDPLoadTestSubsystem::OnWorldTickStart);
+
+	if (UWorld* World = GetWorld())
+	{
+		PostTickFlushHandle = World->OnPostTickFlush().AddUObject(this, &UPDPLoadTestSubsystem::OnPostTickFlush);
+	}
+}
+
+void UPDPLoadTestSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(TickStartHandle);
+
+	if (UWorld* World = GetWorld())
+	{
+		World->OnPostTickFlush().Remove(PostTickFlushHandle);
+	}
+
+	Super::Deinitialize();
+}
+
+void UPDPLoadTestSubsystem::StartLoadTest(bool bInExitWhenDone)
+{
+	UWorld* World = GetWorld();
+	if (!World || !World->GetAuthGameMode<APDPMultiplayerGameMode>() || Phase != EPhase::Idle)
+	{
+		return;
+	}
+
+	bExitWhenDone = bInExitWhenDone;
+	Report = TEXT("Bots,Frames,FrameP50,FrameP90,FrameP99,GameThreadP50,GameThreadP90,GameThreadP99,ReplicationP50,ReplicationP90,ReplicationP99\n");
+
+	StartStep(FMath::Max(MinBots, 1));
+}
+
+void UPDPLoadTestSubsystem::StartStep(int32 NumBots)
+{
+	StepBots = NumBots;
+
+	APDPMultiplayerGameMode* GameMode = GetWorld()->GetAuthGameMode<APDPMultiplayerGameMode>();
+	if (!GameMode)
+	{
+		FinishLoadTest();
+		return;
+	}
+
+	GameMode->SpawnBots(StepBots - GameMode->GetNumBots());
+
+	FrameTimes.Reset();
+	GameThreadTimes.Reset();
+	ReplicationTimes.Reset();
+
+	Phase = EPhase::Warmup;
+	PhaseEndTime = FPlatformTime::Seconds() + WarmupSeconds;
+}
+
+void UPDPLoadTestSubsystem::OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld())
+	{
+		TickStartTime = FPlatformTime::Seconds();
+	}
+}
+
+void UPDPLoadTestSubsystem::OnPostTickFlush()
+{
+	if (Phase == EPhase::Idle)
+	{
+		return;
+	}
+
+	// The world tick ends with the net driver flush, so this covers gameplay and replication but not the frame rate limiter.
+	const double Now = FPlatformTime::Seconds();
+	if (Phase == EPhase::Sampling)
+	{
+		FrameTimes.Add(FApp::GetDeltaTime() * 1000.0);
+		GameThreadTimes.Add((Now - TickStartTime) * 1000.0);
+		ReplicationTimes.Add(GetReplicationTimeMs());
+	}
+
+	if (Now < PhaseEndTime)
+	{
+		return;
+	}
+
+	if (Phase == EPhase::Warmup)
+	{
+		Phase = EPhase::Sampling;
+		PhaseEndTime = Now + SampleSeconds;
+		return;
+	}
+
+	ReportStep();
+
+	if (StepBots >= MaxBots)
+	{
+		FinishLoadTest();
+		return;
+	}
+
+	StartStep(FMath::Min(StepBots * 2, MaxBots));
+}
+
+float UPDPLoadTestSubsystem::GetReplicationTimeMs() const
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	const UPDPReplicationGraph* ReplicationGraph = NetDriver ? Cast<UPDPReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+
+	return ReplicationGraph ? ReplicationGraph->GetLastReplicationTimeMs() : 0.0f;
+}
+
+void UPDPLoadTestSubsystem::ReportStep()
+{
+	FrameTimes.Sort();
+	GameThreadTimes.Sort();
+	ReplicationTimes.Sort();
+
+	UE_LOG(LogPDPMultiplayer, Display, TEXT("LoadTest: %d bots, %d frames | frame p50 %.2f p90 %.2f p99 %.2f ms | game thread p50 %.2f p90 %.2f p99 %.2f ms | replication p50 %.2f p90 %.2f p99 %.2f ms"),
+		StepBots, FrameTimes.Num(),
+		GetPercentile(FrameTimes, 0.5f), GetPercentile(FrameTimes, 0.9f), GetPercentile(FrameTimes, 0.99f),
+		GetPercentile(GameThreadTimes, 0.5f), GetPercentile(GameThreadTimes, 0.9f), GetPercentile(GameThreadTimes, 0.99f),
+		GetPercentile(ReplicationTimes, 0.5f), GetPercentile(ReplicationTimes, 0.9f), GetPercentile(ReplicationTimes, 0.99f));
+
+	Report += FString::Printf(TEXT("%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n"),
+		StepBots, FrameTimes.Num(),
+		GetPercentile(FrameTimes, 0.5f), GetPercentile(FrameTimes, 0.9f), GetPercentile(FrameTimes, 0.99f),
+		GetPercentile(GameThreadTimes, 0.5f), GetPercentile(GameThreadTimes, 0.9f), GetPercentile(GameThreadTimes, 0.99f),
+		GetPercentile(ReplicationTimes, 0.5f), GetPercentile(ReplicationTimes, 0.9f), GetPercentile(ReplicationTimes, 0.99f));
+}
+
+void UPDPLoadTestSubsystem::FinishLoadTest()
+{
+	Phase = EPhase::Idle;
+
+	const FString ReportPath = FPaths::ProfilingDir() / FString::Printf(TEXT("PDPLoadTest-%s.csv"), *FDateTime::Now().ToString());
+	if (FFileHelper::SaveStringToFile(Report, *ReportPath))
+	{
+		UE_LOG(LogPDPMultiplayer, Display, TEXT("LoadTest: report written to %s"), *ReportPath);
+	}
+
+	if (bExitWhenDone)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
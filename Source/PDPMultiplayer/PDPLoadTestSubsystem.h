@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PDPLoadTestSubsystem.generated.h"
+
+/**
+ * Server load test. Bots are added by steps, doubling from MinBots up to MaxBots. At every step the
+ * frames are sampled once the match has warmed up, and the 50th, 90th and 99th percentiles of the
+ * server frame time, game thread time and replication time are logged and written to a CSV file in
+ * the profiling directory.
+ *
+ * Started with -PDPLoadTest on a dedicated server, typically with -nullrhi, or with PDP.LoadTest.
+ */
+UCLASS(config=Game)
+class PDPMULTIPLAYER_API UPDPLoadTestSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** @param bInExitWhenDone	Requests the process exit once the last step is reported */
+	void StartLoadTest(bool bInExitWhenDone);
+
+	UPROPERTY(config)
+	int32 MinBots = 8;
+
+	UPROPERTY(config)
+	int32 MaxBots = 128;
+
+	/** Seconds the match runs after bots are added before it is sampled. */
+	UPROPERTY(config)
+	float WarmupSeconds = 5.0f;
+
+	/** Seconds sampled at every step. */
+	UPROPERTY(config)
+	float SampleSeconds = 20.0f;
+
+private:
+	enum class EPhase : uint8
+	{
+		Idle,
+		Warmup,
+		Sampling
+	};
+
+	void OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+	void OnPostTickFlush();
+
+	void StartStep(int32 NumBots);
+	void ReportStep();
+	void FinishLoadTest();
+
+	float GetReplicationTimeMs() const;
+
+	EPhase Phase = EPhase::Idle;
+	bool bExitWhenDone = false;
+
+	int32 StepBots = 0;
+	double PhaseEndTime = 0.0;
+	double TickStartTime = 0.0;
+
+	TArray<float> FrameTimes;
+	TArray<float> GameThreadTimes;
+	TArray<float> ReplicationTimes;
+
+	FString Report;
+
+	FDelegateHandle TickStartHandle;
+	FDelegateHandle PostTickFlushHandle;
+};
@@ -8,6 +8,12 @@ public class PDPMultiplayer : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "ReplicationGraph", "AIModule", "NetCore" });
+
+		// A dedicated server has no headset to reset, client-only code is compiled out with UE_SERVER.
+		if (Target.Type != TargetType.Server)
+		{
+			PublicDependencyModuleNames.Add("HeadMountedDisplay");
+		}
 	}
 }
@@ -1,7 +1,64 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "PDPMultiplayer.h"
+#include "PDPReplicationGraph.h"
+#include "Engine/NetDriver.h"
+#include "Engine/ReplicationDriver.h"
+#include "HAL/IConsoleManager.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, PDPMultiplayer, "PDPMultiplayer" );
- 
\ No newline at end of file
+static int32 GUseReplicationGraph = 1;
+static FAutoConsoleVariableRef CVarUseReplicationGraph(
+	TEXT("PDP.ReplicationGraph.Enable"),
+	GUseReplicationGraph,
+	TEXT("Use the project replication graph for the game net driver. 0 falls back to the default relevancy path. Read when the net driver is created."),
+	ECVF_Default);
+
+DEFINE_LOG_CATEGORY(LogPDPMultiplayer);
+
+DEFINE_STAT(STAT_PDP_LineTrace);
+DEFINE_STAT(STAT_PDP_ServerShot);
+DEFINE_STAT(STAT_PDP_ConfirmHit);
+DEFINE_STAT(STAT_PDP_RecordHitboxes);
+DEFINE_STAT(STAT_PDP_QueueDamage);
+DEFINE_STAT(STAT_PDP_ResolveDamage);
+DEFINE_STAT(STAT_PDP_Respawn);
+DEFINE_STAT(STAT_PDP_ChooseSpawnPoint);
+DEFINE_STAT(STAT_PDP_UpdateCorpses);
+DEFINE_STAT(STAT_PDP_HUDUpdate);
+DEFINE_STAT(STAT_PDP_RecordReplay);
+DEFINE_STAT(STAT_PDP_AnimationBudget);
+
+DEFINE_STAT(STAT_PDP_Shots);
+DEFINE_STAT(STAT_PDP_Hits);
+DEFINE_STAT(STAT_PDP_Deaths);
+DEFINE_STAT(STAT_PDP_Respawns);
+DEFINE_STAT(STAT_PDP_Corpses);
+
+CSV_DEFINE_CATEGORY_MODULE(PDPMULTIPLAYER_API, PDP, true);
+
+UE_TRACE_CHANNEL_DEFINE(PDPChannel);
+
+class FPDPMultiplayerModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		UReplicationDriver::CreateReplicationDriverDelegate().BindLambda([](UNetDriver* ForNetDriver, const FURL& URL, UWorld* World) -> UReplicationDriver*
+		{
+			if (!GUseReplicationGraph || ForNetDriver->NetDriverName != NAME_GameNetDriver)
+			{
+				return nullptr;
+			}
+
+			return NewObject<UPDPReplicationGraph>(GetTransientPackage());
+		});
+	}
+
+	virtual void ShutdownModule() override
+	{
+		UReplicationDriver::CreateReplicationDriverDelegate().Unbind();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FPDPMultiplayerModule, PDPMultiplayer, "PDPMultiplayer" );
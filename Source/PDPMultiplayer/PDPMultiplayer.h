@@ -3,3 +3,55 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogPDPMultiplayer, Log, All);
+
+// Gameplay profiling, "stat PDP" on the console. Everything below is compiled out in Shipping.
+DECLARE_STATS_GROUP(TEXT("PDPMultiplayer"), STATGROUP_PDP, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Line Trace"), STAT_PDP_LineTrace, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Server Shot"), STAT_PDP_ServerShot, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Confirm Hit"), STAT_PDP_ConfirmHit, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Record Hitboxes"), STAT_PDP_RecordHitboxes, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Queue Damage"), STAT_PDP_QueueDamage, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Resolve Damage"), STAT_PDP_ResolveDamage, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Respawn"), STAT_PDP_Respawn, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Choose Spawn Point"), STAT_PDP_ChooseSpawnPoint, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Corpses"), STAT_PDP_UpdateCorpses, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("HUD Update"), STAT_PDP_HUDUpdate, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Record Replay"), STAT_PDP_RecordReplay, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Animation Budget"), STAT_PDP_AnimationBudget, STATGROUP_PDP, PDPMULTIPLAYER_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Shots"), STAT_PDP_Shots, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Hits"), STAT_PDP_Hits, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Deaths"), STAT_PDP_Deaths, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Respawns"), STAT_PDP_Respawns, STATGROUP_PDP, PDPMULTIPLAYER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Corpses"), STAT_PDP_Corpses, STATGROUP_PDP, PDPMULTIPLAYER_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(PDPMULTIPLAYER_API, PDP);
+
+UE_TRACE_CHANNEL_EXTERN(PDPChannel, PDPMULTIPLAYER_API);
+
+#if !UE_BUILD_SHIPPING
+
+/** Times the enclosing scope in the stat group, in CSV captures and on the PDP Insights trace channel. */
+#define PDP_SCOPE_CYCLE_COUNTER(Stat, Name) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	CSV_SCOPED_TIMING_STAT(PDP, Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(PDP_##Name, PDPChannel)
+
+/** Adds Amount to an accumulator stat and to the matching CSV stat of this frame. */
+#define PDP_INC_COUNTER(Stat, Name, Amount) \
+	INC_DWORD_STAT_BY(Stat, Amount); \
+	CSV_CUSTOM_STAT(PDP, Name, Amount, ECsvCustomStatOp::Accumulate)
+
+#else
+
+#define PDP_SCOPE_CYCLE_COUNTER(Stat, Name)
+#define PDP_INC_COUNTER(Stat, Name, Amount)
+
+#endif
@@ -2,24 +2,44 @@
 
 #include "PDPMultiplayerCharacter.h"
 
-#include "DrawDebugHelpers.h"
-#include "HeadMountedDisplayFunctionLibrary.h"
+#include "PDPMultiplayer.h"
+#include "PDPCorpseSubsystem.h"
+#include "PDPDamageSubsystem.h"
+#include "PDPLagCompensationSubsystem.h"
 #include "PDPMultiplayerGameMode.h"
 #include "PDPMultiplayerHUD.h"
+#include "PDPNetAccountingSubsystem.h"
+#include "PDPNetPolicyComponent.h"
+#include "PDPPlayerState.h"
+#include "PDPPreloadSubsystem.h"
+#include "PDPReplaySubsystem.h"
+#include "PDPShotTraceSubsystem.h"
+#include "PDPSkeletalMeshComponent.h"
+#include "PDPWeaponComponent.h"
+#include "PDPWeaponDefinition.h"
 #include "Camera/CameraComponent.h"
-#include "Components/AudioComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/ActorChannel.h"
+#include "Engine/GameInstance.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
 #include "GameFramework/SpringArmComponent.h"
-#include "Kismet/GameplayStatics.h"
 #include "Net/UnrealNetwork.h"
+#include "Sound/SoundAttenuation.h"
+
+#if !UE_SERVER
+#include "HeadMountedDisplayFunctionLibrary.h"
+#endif
 
 //////////////////////////////////////////////////////////////////////////
 // APDPMultiplayerCharacter
 
-APDPMultiplayerCharacter::APDPMultiplayerCharacter()
+APDPMultiplayerCharacter::APDPMultiplayerCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UPDPSkeletalMeshComponent>(ACharacter::MeshComponentName))
 {
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
@@ -50,11 +70,14 @@ APDPMultiplayerCharacter::APDPMultiplayerCharacter()
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
+	// Create the weapon, its definition asset is set in the derived blueprint
+	Weapon = CreateDefaultSubobject<UPDPWeaponComponent>(TEXT("Weapon"));
+
+	NetPolicy = CreateDefaultSubobject<UPDPNetPolicyComponent>(TEXT("NetPolicy"));
+
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
 
-	OnTakeAnyDamage.AddDynamic(this, &APDPMultiplayerCharacter::Server_TakeDamage);
-
 	SetReplicates(true);
 }
 
@@ -72,11 +95,11 @@ void APDPMultiplayerCharacter::SetupPlayerInputComponent(class UInputComponent*
 	PlayerInputComponent->BindAxis("MoveRight", this, &APDPMultiplayerCharacter::MoveRight);
 
 	// Change camera side
-	PlayerInputComponent->BindAction("ChangeCameraLeft", IE_Pressed, this, &APDPMultiplayerCharacter::Server_ChangeCameraSideLeft);
-	PlayerInputComponent->BindAction("ChangeCameraRight", IE_Pressed, this, &APDPMultiplayerCharacter::Server_ChangeCameraSideRight);
+	PlayerInputComponent->BindAction("ChangeCameraLeft", IE_Pressed, this, &APDPMultiplayerCharacter::ChangeCameraSideLeft);
+	PlayerInputComponent->BindAction("ChangeCameraRight", IE_Pressed, this, &APDPMultiplayerCharacter::ChangeCameraSideRight);
 
 	// Shot
-	PlayerInputComponent->BindAction("Shot", IE_Pressed, this, &APDPMultiplayerCharacter::Server_Shot);
+	PlayerInputComponent->BindAction("Shot", IE_Pressed, this, &APDPMultiplayerCharacter::Fire);
 	
 	// We have 2 versions of the rotation bindings to handle different kinds of devices differently
 	// "turn" handles devices that provide an absolute delta, such as a mouse.
@@ -103,7 +126,9 @@ void APDPMultiplayerCharacter::OnResetVR()
 	//		Add "HeadMountedDisplay" to [YourProject].Build.cs PublicDependencyModuleNames in order to build successfully (appropriate if supporting VR).
 	// or:
 	//		Comment or delete the call to ResetOrientationAndPosition below (appropriate if not supporting VR)
+#if !UE_SERVER
 	UHeadMountedDisplayFunctionLibrary::ResetOrientationAndPosition();
+#endif
 }
 
 void APDPMultiplayerCharacter::TouchStarted(ETouchIndex::Type FingerIndex, FVector Location)
@@ -118,7 +143,10 @@ void APDPMultiplayerCharacter::TouchStopped(ETouchIndex::Type FingerIndex, FVect
 
 AActor* APDPMultiplayerCharacter::LineTrace()
 {
+	PDP_SCOPE_CYCLE_COUNTER(STAT_PDP_LineTrace, LineTrace);
+
 	UWorld* World = GetWorld();
+	const UPDPWeaponDefinition* WeaponDefinition = Weapon->GetDefinition();
 	if (!World)
 	{
 		return nullptr;
@@ -126,314 +154,624 @@ AActor* APDPMultiplayerCharacter::LineTrace()
 	
 	FHitResult HitResult;
 	const FVector TraceStart = FollowCamera->GetComponentLocation();
-	const FVector TraceEnd = FollowCamera->GetForwardVector() * TraceDistance + TraceStart;
+	const FVector TraceEnd = FollowCamera->GetForwardVector() * WeaponDefinition->TraceDistance + TraceStart;
 
 	FCollisionQueryParams QueryParams;
 	QueryParams.AddIgnoredActor(this);
 	
 	World->LineTraceSingleByChannel(HitResult, TraceStart, TraceEnd, ECollisionChannel::ECC_Visibility, QueryParams);
-	DrawDebugLine(World, TraceStart, TraceEnd, FColor::Green, true);
+
+#if !UE_BUILD_SHIPPING
+	if (UPDPShotTraceSubsystem* ShotTraces = World->GetSubsystem<UPDPShotTraceSubsystem>())
+	{
+		ShotTraces->RecordTrace(this, LastPredictedShotId, TraceStart, TraceEnd, HitResult.GetActor(), HitResult.ImpactPoint);
+	}
+#endif
 	
 	return HitResult.Actor.Get();
 }
 
-void APDPMultiplayerCharacter::PossessedBy(AController* NewController)
+void APDPMultiplayerCharacter::PostInitializeComponents()
 {
-	Super::PossessedBy(NewController);
+	Super::PostInitializeComponents();
 
-	FTimerHandle TimerHandle;
-	UWorld* World = GetWorld();
-	if (!World)
+	DefaultMeshRelativeTransform = GetMesh()->GetRelativeTransform();
+	DefaultMeshCollisionProfile = GetMesh()->GetCollisionProfileName();
+	DefaultCameraLocation = FollowCamera->GetRelativeLocation();
+
+	if (GetLocalRole() == ROLE_Authority)
 	{
-		return;
+		State.Health = MaxHealth;
+		State.Ammo = Weapon->GetMaxAmmo();
 	}
-
-	World->GetTimerManager().SetTimer(TimerHandle, this, &APDPMultiplayerCharacter::Client_DrawUI, 0.3f, false);
-
-	CanTakeDamage = true;
 }
 
-bool APDPMultiplayerCharacter::Server_TakeDamage_Validate(AActor* DamagedActor, float Damage,
-                                                          const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser)
+void APDPMultiplayerCharacter::DeactivateForPool()
 {
-	return DamagedActor != nullptr && Damage > 0.0f;
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+
+	GetMesh()->SetSimulatePhysics(false);
+	GetMesh()->SetComponentTickEnabled(false);
+	GetCharacterMovement()->DisableMovement();
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+	NetPolicy->SetPolicyEnabled(false);
+
+	// Pooled characters stay dormant, the hidden flag is sent once more before that.
+	FlushNetDormancy();
+	ForceNetUpdate();
+	SetNetDormancy(DORM_DormantAll);
 }
 
-void APDPMultiplayerCharacter::Server_TakeDamage_Implementation(AActor* DamagedActor, float Damage,
-	const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser)
+void APDPMultiplayerCharacter::ResetForRespawn(const FTransform& SpawnTransform)
 {
-	if (CanTakeDamage)
-	{
-		if (APDPMultiplayerCharacter* Player = Cast<APDPMultiplayerCharacter>(DamagedActor))
-		{
-			Player->Health -= Damage;
+	SetNetDormancy(DORM_Awake);
 
-			if (GetLocalRole() == ROLE_Authority)
-			{
-				OnHealthChangedDelegate.ExecuteIfBound(Health);
-			}
+	ResetRagdoll();
+	SetActorTransform(SpawnTransform, false, nullptr, ETeleportType::ResetPhysics);
 
-			if (Player->Health <= 0)
-			{
-				CanTakeDamage = false;
-				CanShoot = false;
-				Client_DeleteUI();
-				Multicast_Ragdoll();
-
-				UWorld* World = GetWorld();
-				if (!World)
-				{
-					return;
-				}
-
-				APDPMultiplayerGameMode* GameMode = Cast<APDPMultiplayerGameMode>(World->GetAuthGameMode());
-				if (!World->GetAuthGameMode())
-				{
-					return;
-				}
-
-				AController* CharacterController = Player->GetController();
-				if (!CharacterController)
-				{
-					return;
-				}
-			
-				FTimerDelegate RespawnDelegate;
-				RespawnDelegate.BindUObject(GameMode, &APDPMultiplayerGameMode::Respawn, CharacterController);
+	State.Health = MaxHealth;
+	State.Ammo = Weapon->GetMaxAmmo();
+	State.bLeftShoulder = false;
+	State.bDead = false;
+	FollowCamera->SetRelativeLocation(DefaultCameraLocation);
 
-				FTimerHandle RespawnTimerHandle;
-				GetWorld()->GetTimerManager().SetTimer(RespawnTimerHandle, RespawnDelegate, 2.0f, false);
+	CanTakeDamage = true;
+	Weapon->ResetCooldown();
 
-				AddScore(InstigatedBy); //TODO: rework it
-			}
-		}
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+	GetMesh()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetComponentTickEnabled(true);
+	NetPolicy->SetPolicyEnabled(true);
+
+	// The history of the previous life must not be rewound into.
+	if (UPDPLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UPDPLagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterCharacter(this);
+		LagCompensation->RegisterCharacter(this);
 	}
-}
 
-bool APDPMultiplayerCharacter::Multicast_Ragdoll_Validate()
-{
-	return true;
+	ForceNetUpdate();
 }
 
-void APDPMultiplayerCharacter::Multicast_Ragdoll_Implementation()
+void APDPMultiplayerCharacter::BeginPlay()
 {
-	UCapsuleComponent* Capsule = GetCapsuleComponent();
-	if (IsValid(Capsule))
+	Super::BeginPlay();
+
+	PredictedAmmo = State.Ammo;
+
+	if (GetLocalRole() == ROLE_Authority)
 	{
-		Capsule->DestroyComponent();
-		GetMesh()->SetSimulatePhysics(true);
+		if (UPDPLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UPDPLagCompensationSubsystem>())
+		{
+			LagCompensation->RegisterCharacter(this);
+		}
 	}
-	
 }
 
-void APDPMultiplayerCharacter::OnHealthChanged() const
+void APDPMultiplayerCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	OnHealthChangedDelegate.ExecuteIfBound(Health);
+	if (UWorld* World = GetWorld())
+	{
+		if (UPDPLagCompensationSubsystem* LagCompensation = World->GetSubsystem<UPDPLagCompensationSubsystem>())
+		{
+			LagCompensation->UnregisterCharacter(this);
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
-bool APDPMultiplayerCharacter::Server_Shot_Validate()
+void APDPMultiplayerCharacter::PossessedBy(AController* NewController)
 {
-	return true;
+	Super::PossessedBy(NewController);
+
+	CanTakeDamage = true;
 }
 
-void APDPMultiplayerCharacter::Server_Shot_Implementation()
+void APDPMultiplayerCharacter::PawnClientRestart()
 {
-	if (CanShoot)
+	Super::PawnClientRestart();
+
+	// Called on the owning client as soon as its controller has the character, the HUD needs no delay.
+	SetIsDead(); //TODO: rework it
+
+#if !UE_SERVER
+	const APlayerController* PlayerController = Cast<APlayerController>(Controller);
+	if (APDPMultiplayerHUD* MyHUD = PlayerController ? Cast<APDPMultiplayerHUD>(PlayerController->GetHUD()) : nullptr)
 	{
-		if (Ammo > 0)
-		{
-			Multicast_ShotSFX(Shot);
-			
-			CanShoot = false;
+		MyHUD->ShowForCharacter(this);
+	}
+#endif
 
-			UWorld* World = GetWorld();
-			if (World)
-			{
-				FTimerHandle TimerHandle;
-				World->GetTimerManager().SetTimer(TimerHandle, [&]()
-				{
-					CanShoot = true;
-				}, 0.2f, false);
-			}
-			
-			--Ammo;
-			
-			if (GetLocalRole() == ROLE_Authority)
-			{
-				OnAmmoChangedDelegate.ExecuteIfBound(Ammo);
-			}
-			
-			Client_TraceOnClient();
-		}
-		else
-		{
-			Multicast_ShotSFX(NoAmmo);
-		}
+	const UGameInstance* GameInstance = GetGameInstance();
+	if (UPDPPreloadSubsystem* Preload = GameInstance ? GameInstance->GetSubsystem<UPDPPreloadSubsystem>() : nullptr)
+	{
+		Preload->NotifyPawnClientRestart();
 	}
 }
 
-bool APDPMultiplayerCharacter::Multicast_ShotSFX_Validate(USoundBase* Sound)
+float APDPMultiplayerCharacter::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
-	return Sound != nullptr;
-}
+	PDP_SCOPE_CYCLE_COUNTER(STAT_PDP_QueueDamage, QueueDamage);
 
-void APDPMultiplayerCharacter::Multicast_ShotSFX_Implementation(USoundBase* Sound)
-{
-	UGameplayStatics::SpawnSoundAttached(Sound, RootComponent, NAME_None, FVector(ForceInit), FRotator::ZeroRotator, EAttachLocation::KeepRelativeOffset, false, 1, 1, 0, WeaponSoundAttenuation)->Play();
+	const float ActualDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+	if (GetLocalRole() != ROLE_Authority || !CanTakeDamage || ActualDamage <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	// Health changes once per tick, when the damage subsystem resolves all the hits of the frame.
+	if (UPDPDamageSubsystem* Damage = GetWorld()->GetSubsystem<UPDPDamageSubsystem>())
+	{
+		Damage->QueueDamage(this, ActualDamage, EventInstigator);
+	}
+
+	return ActualDamage;
 }
 
-bool APDPMultiplayerCharacter::Client_TraceOnClient_Validate()
+void APDPMultiplayerCharacter::ApplyResolvedDamage(float Damage)
 {
-	return true;
+	State.Health -= Damage;
+	OnHealthChangedDelegate.ExecuteIfBound(State.Health);
+
+	NetPolicy->NotifyActivity();
 }
 
-void APDPMultiplayerCharacter::Client_TraceOnClient_Implementation()
+void APDPMultiplayerCharacter::Die(AController* Killer)
 {
-	if (AActor* HitActor = LineTrace())
+	PDP_INC_COUNTER(STAT_PDP_Deaths, Deaths, 1);
+
+	CanTakeDamage = false;
+
+	// Remote owners hide their HUD when the dead flag replicates.
+	HideHUD();
+
+	// Clients ragdoll when the dead flag replicates, late joiners included.
+	State.bDead = true;
+	Ragdoll();
+
+	// Sent before the character goes dormant. Bots have no client to show it to.
+	if (UPDPReplaySubsystem* Replay = GetWorld()->GetSubsystem<UPDPReplaySubsystem>())
 	{
-		if (HitActor->ActorHasTag("Player"))
+		FPDPKillCam KillCam;
+		if (Replay->RecordDeath(this, Killer, KillCam) && Cast<APlayerController>(GetController()))
 		{
-			Server_TraceOnServer();
+			Client_PlayKillCam(KillCam);
 		}
 	}
+
+	// The corpse replicates the dead flag one last time and then goes dormant, its rate no longer matters.
+	NetPolicy->SetPolicyEnabled(false);
+	ForceNetUpdate();
+	SetNetDormancy(DORM_DormantAll);
+
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	APDPMultiplayerGameMode* GameMode = Cast<APDPMultiplayerGameMode>(World->GetAuthGameMode());
+	if (!GameMode)
+	{
+		return;
+	}
+
+	AController* CharacterController = GetController();
+	GameMode->ScoreKill(Killer, CharacterController);
+
+	// Until PDP_PlayerState is reparented, the Blueprint keeps the score.
+	if (!Killer || !Killer->GetPlayerState<APDPPlayerState>())
+	{
+		AddScore(Killer);
+	}
+
+	if (!CharacterController)
+	{
+		return;
+	}
+
+	FTimerDelegate RespawnDelegate;
+	RespawnDelegate.BindUObject(GameMode, &APDPMultiplayerGameMode::Respawn, CharacterController);
+
+	FTimerHandle RespawnTimerHandle;
+	World->GetTimerManager().SetTimer(RespawnTimerHandle, RespawnDelegate, 2.0f, false);
 }
 
-bool APDPMultiplayerCharacter::Server_TraceOnServer_Validate()
+bool APDPMultiplayerCharacter::Client_PlayKillCam_Validate(const FPDPKillCam& KillCam)
 {
 	return true;
 }
 
-void APDPMultiplayerCharacter::Server_TraceOnServer_Implementation()
+void APDPMultiplayerCharacter::Client_PlayKillCam_Implementation(const FPDPKillCam& KillCam)
 {
-	if (AActor* HitActor = LineTrace())
+#if !UE_SERVER
+	APlayerController* PlayerController = Cast<APlayerController>(Controller);
+	if (UPDPReplaySubsystem* Replay = PlayerController ? GetWorld()->GetSubsystem<UPDPReplaySubsystem>() : nullptr)
 	{
-		HitActor->TakeDamage(DamageAmount, FDamageEvent(), Controller, nullptr);
+		Replay->PlayKillCam(PlayerController, KillCam);
 	}
+#endif
 }
 
-bool APDPMultiplayerCharacter::Client_DrawUI_Validate()
+void APDPMultiplayerCharacter::Ragdoll()
 {
-	return true;
+	// The capsule is kept so the character can be reused by the pawn pool.
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	GetCharacterMovement()->DisableMovement();
+
+	GetMesh()->SetCollisionProfileName(TEXT("Ragdoll"));
+	GetMesh()->SetSimulatePhysics(true);
+
+	if (UPDPCorpseSubsystem* Corpses = GetWorld()->GetSubsystem<UPDPCorpseSubsystem>())
+	{
+		Corpses->AddCorpse(this);
+	}
 }
 
-void APDPMultiplayerCharacter::Client_DrawUI_Implementation()
+void APDPMultiplayerCharacter::FreezeRagdoll()
 {
-	SetIsDead(); //TODO: rework it
+	// The skeleton isn't updated anymore, so the bodies can leave the physics scene without the pose snapping back.
+	USkeletalMeshComponent* CharacterMesh = GetMesh();
+	CharacterMesh->bNoSkeletonUpdate = true;
+	CharacterMesh->SetComponentTickEnabled(false);
+	CharacterMesh->SetSimulatePhysics(false);
+	CharacterMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+}
+
+void APDPMultiplayerCharacter::ResetRagdoll()
+{
+	if (UPDPCorpseSubsystem* Corpses = GetWorld()->GetSubsystem<UPDPCorpseSubsystem>())
+	{
+		Corpses->RemoveCorpse(this);
+	}
 
+	USkeletalMeshComponent* CharacterMesh = GetMesh();
+	CharacterMesh->bNoSkeletonUpdate = false;
+	CharacterMesh->SetComponentTickEnabled(true);
+	CharacterMesh->SetSimulatePhysics(false);
+	CharacterMesh->SetCollisionProfileName(DefaultMeshCollisionProfile);
+	CharacterMesh->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+	CharacterMesh->SetRelativeTransform(DefaultMeshRelativeTransform);
 
-	
-	if (GetController()->IsLocalController())
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+}
+
+void APDPMultiplayerCharacter::OnStateChanged(const FPDPCharacterState& PreviousState)
+{
+	if (State.bDead && !PreviousState.bDead)
+	{
+		HideHUD();
+	}
+
+	// Reused by the pawn pool on the server.
+	const bool bRespawned = !State.bDead && PreviousState.bDead;
+	if (bRespawned)
+	{
+		ResetRagdoll();
+		ResetPredictedShots();
+		FollowCamera->SetRelativeLocation(DefaultCameraLocation);
+	}
+
+	if (State.Health != PreviousState.Health)
+	{
+		OnHealthChangedDelegate.ExecuteIfBound(State.Health);
+	}
+
+	if (State.Ammo != PreviousState.Ammo)
 	{
-		if (!Controller)
+		if (GetLocalRole() == ROLE_AutonomousProxy)
 		{
-			return;
+			ReconcilePredictedShots();
 		}
-
-		APlayerController* PlayerController = Cast<APlayerController>(Controller);
-		if (!PlayerController)
+		else
 		{
-			return;
+			OnAmmoChangedDelegate.ExecuteIfBound(State.Ammo);
 		}
+	}
+
+	// The owning client has already moved its camera when the input was pressed.
+	if (State.bLeftShoulder != PreviousState.bLeftShoulder && !IsLocallyControlled() && !bRespawned)
+	{
+		ApplyShoulderSide(State.bLeftShoulder);
+	}
+
+	if (State.bDead && !PreviousState.bDead)
+	{
+		Ragdoll();
+	}
+}
 
-		AHUD* HUD = PlayerController->GetHUD();
-		if (!HUD)
+void APDPMultiplayerCharacter::Fire()
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	// The owning client predicts the shot so ammo, cooldown and sound don't wait for the round trip.
+	if (GetLocalRole() == ROLE_AutonomousProxy)
+	{
+		if (!CanShoot())
 		{
 			return;
 		}
 
-		APDPMultiplayerHUD* MyHUD = Cast<APDPMultiplayerHUD>(HUD);
-		if (!MyHUD)
+		++LastPredictedShotId;
+
+		if (PredictedAmmo > 0)
 		{
-			return;
-		}
+			PlayShotSFX(false);
+			Weapon->NotifyFired();
 
-		MyHUD->DrawIU();
+			--PredictedAmmo;
+			PendingShotIds.Add(LastPredictedShotId);
+			OnAmmoChangedDelegate.ExecuteIfBound(PredictedAmmo);
+
+#if !UE_BUILD_SHIPPING
+			// The client only traces for the shot trace view, the server resolves the hit.
+			if (UPDPShotTraceSubsystem::IsEnabled())
+			{
+				LineTrace();
+			}
+#endif
+		}
+		else
+		{
+			PlayShotSFX(true);
+		}
 	}
+
+	const AGameStateBase* GameState = World->GetGameState();
+	const float ClientTime = GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+
+	Server_Shot(FollowCamera->GetComponentLocation(), FollowCamera->GetForwardVector(), ClientTime, LastPredictedShotId);
 }
 
-bool APDPMultiplayerCharacter::Client_DeleteUI_Validate()
+bool APDPMultiplayerCharacter::Server_Shot_Validate(const FVector_NetQuantize& TraceStart, const FVector_NetQuantizeNormal& TraceDirection, float ClientTime, uint16 ShotId)
 {
-	return true;
+	return !TraceDirection.IsNearlyZero();
 }
 
-void APDPMultiplayerCharacter::Client_DeleteUI_Implementation()
+void APDPMultiplayerCharacter::Server_Shot_Implementation(const FVector_NetQuantize& TraceStart, const FVector_NetQuantizeNormal& TraceDirection, float ClientTime, uint16 ShotId)
 {
-	if (GetController()->IsLocalController())
+	PDP_SCOPE_CYCLE_COUNTER(STAT_PDP_ServerShot, ServerShot);
+
+	if (UPDPNetAccountingSubsystem* NetAccounting = GetWorld()->GetSubsystem<UPDPNetAccountingSubsystem>())
 	{
-		if (!Controller)
+		NetAccounting->RecordIncomingRPC(GetNetConnection(), GET_FUNCTION_NAME_CHECKED(APDPMultiplayerCharacter, Server_Shot));
+	}
+
+	// Replicates together with State, so the owning client knows which of its predicted shots the ammo includes.
+	LastConfirmedShotId = ShotId;
+
+	// Jitter can bunch up shots the client fired at the right rate.
+	if (CanShoot(Weapon->GetDefinition()->MaxFireIntervalError))
+	{
+		if (State.Ammo > 0)
 		{
-			return;
+			BroadcastShotSFX(false);
+			
+			Weapon->NotifyFired();
+			NetPolicy->NotifyActivity();
+			PDP_INC_COUNTER(STAT_PDP_Shots, Shots, 1);
+			
+			--State.Ammo;
+			
+			if (GetLocalRole() == ROLE_Authority)
+			{
+				OnAmmoChangedDelegate.ExecuteIfBound(State.Ammo);
+			}
+
+			UWorld* World = GetWorld();
+			if (!World)
+			{
+				return;
+			}
+
+			UPDPLagCompensationSubsystem* LagCompensation = World->GetSubsystem<UPDPLagCompensationSubsystem>();
+			if (!LagCompensation)
+			{
+				return;
+			}
+
+			const UPDPWeaponDefinition* WeaponDefinition = Weapon->GetDefinition();
+
+			// Trust the client trace origin only as long as it stays close to where the server has the camera.
+			const FVector ServerTraceStart = FollowCamera->GetComponentLocation();
+			const FVector ConfirmedTraceStart = FVector::DistSquared(TraceStart, ServerTraceStart) <= FMath::Square(WeaponDefinition->MaxTraceStartError) ? FVector(TraceStart) : ServerTraceStart;
+			const FVector TraceEnd = ConfirmedTraceStart + TraceDirection.GetSafeNormal() * WeaponDefinition->TraceDistance;
+
+			LagCompensation->QueueShot(this, ConfirmedTraceStart, TraceEnd, ClientTime, WeaponDefinition->DamageAmount, ShotId);
+		}
+		else
+		{
+			BroadcastShotSFX(true);
 		}
+	}
+}
+
+void APDPMultiplayerCharacter::BroadcastShotSFX(bool bDryFire)
+{
+	UWorld* World = GetWorld();
+	const UPDPWeaponDefinition* WeaponDefinition = Weapon->GetDefinition();
+	if (!World)
+	{
+		return;
+	}
+
+	const USoundAttenuation* SoundAttenuation = WeaponDefinition->SoundAttenuation;
+	const float AudibleDistanceSquared = SoundAttenuation
+		? FMath::Square(SoundAttenuation->Attenuation.GetMaxDimension())
+		: TNumericLimits<float>::Max();
+	const FVector ShotLocation = GetActorLocation();
 
-		APlayerController* PlayerController = Cast<APlayerController>(Controller);
+	for (FConstPlayerControllerIterator Iterator = World->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		APlayerController* PlayerController = Iterator->Get();
 		if (!PlayerController)
 		{
-			return;
+			continue;
 		}
 
-		AHUD* HUD = PlayerController->GetHUD();
-		if (!HUD)
+		const bool bIsLocal = PlayerController->IsLocalController();
+		if (PlayerController == Controller && !bIsLocal)
 		{
-			return;
+			continue;
 		}
 
-		APDPMultiplayerHUD* MyHUD = Cast<APDPMultiplayerHUD>(HUD);
-		if (!MyHUD)
+		APDPMultiplayerCharacter* Listener = Cast<APDPMultiplayerCharacter>(PlayerController->GetPawn());
+		if (!Listener || FVector::DistSquared(Listener->GetActorLocation(), ShotLocation) > AudibleDistanceSquared)
 		{
-			return;
+			continue;
+		}
+
+		if (bIsLocal)
+		{
+			PlayShotSFX(bDryFire);
 		}
+		else
+		{
+			Listener->Client_PlayShotSFX(this, bDryFire);
+		}
+	}
+}
+
+bool APDPMultiplayerCharacter::Client_PlayShotSFX_Validate(APDPMultiplayerCharacter* Shooter, bool bDryFire)
+{
+	return true;
+}
+
+void APDPMultiplayerCharacter::Client_PlayShotSFX_Implementation(APDPMultiplayerCharacter* Shooter, bool bDryFire)
+{
+	// The shooter is not relevant to this client.
+	if (!Shooter)
+	{
+		return;
+	}
 
+	Shooter->PlayShotSFX(bDryFire);
+}
+
+void APDPMultiplayerCharacter::PlayShotSFX(bool bDryFire)
+{
+	Weapon->PlayFireSound(bDryFire);
+}
+
+void APDPMultiplayerCharacter::HideHUD()
+{
+#if !UE_SERVER
+	const APlayerController* PlayerController = Cast<APlayerController>(Controller);
+	if (!PlayerController || !PlayerController->IsLocalController())
+	{
+		return;
+	}
+
+	if (APDPMultiplayerHUD* MyHUD = Cast<APDPMultiplayerHUD>(PlayerController->GetHUD()))
+	{
 		MyHUD->DeleteUI();
 	}
+#endif
 }
 
-void APDPMultiplayerCharacter::OnAmmoChanged()
+void APDPMultiplayerCharacter::OnLastConfirmedShotIdChanged()
 {
-	OnAmmoChangedDelegate.ExecuteIfBound(Ammo);
+	if (GetLocalRole() == ROLE_AutonomousProxy)
+	{
+		ReconcilePredictedShots();
+	}
 }
 
-bool APDPMultiplayerCharacter::Server_ChangeCameraSideLeft_Validate()
+void APDPMultiplayerCharacter::ReconcilePredictedShots()
 {
-	return true;
+	// Shot ids wrap around, compare them through their signed distance.
+	PendingShotIds.RemoveAll([this](const uint16 ShotId)
+	{
+		return static_cast<int16>(ShotId - LastConfirmedShotId) <= 0;
+	});
+
+	const uint8 ReconciledAmmo = static_cast<uint8>(FMath::Max(State.Ammo - PendingShotIds.Num(), 0));
+	if (ReconciledAmmo != PredictedAmmo)
+	{
+		PredictedAmmo = ReconciledAmmo;
+		OnAmmoChangedDelegate.ExecuteIfBound(PredictedAmmo);
+	}
 }
 
-void APDPMultiplayerCharacter::Server_ChangeCameraSideLeft_Implementation()
+void APDPMultiplayerCharacter::ResetPredictedShots()
 {
-	Multicast_ChangeCameraLeft();
+	PendingShotIds.Reset();
+	PredictedAmmo = State.Ammo;
+	Weapon->ResetCooldown();
+
+	// The replicated ammo may already match the new prediction, in which case nothing else updates the HUD.
+	OnAmmoChangedDelegate.ExecuteIfBound(PredictedAmmo);
 }
 
-bool APDPMultiplayerCharacter::Multicast_ChangeCameraLeft_Validate()
+int32 APDPMultiplayerCharacter::GetPlayerId(const AActor* Actor)
 {
-	return true;
+	const APawn* Pawn = Cast<APawn>(Actor);
+	const APlayerState* PlayerState = Pawn ? Pawn->GetPlayerState() : nullptr;
+	return PlayerState ? PlayerState->GetPlayerId() : INDEX_NONE;
 }
 
-void APDPMultiplayerCharacter::Multicast_ChangeCameraLeft_Implementation()
+bool APDPMultiplayerCharacter::CanShoot(float FireIntervalTolerance) const
 {
-	static const FVector LeftSideCamera = {110.0f, -60.0, 70.0f};
-	
-	FollowCamera->SetRelativeLocation(LeftSideCamera);
+	return !State.bDead && Weapon->IsReadyToFire(FireIntervalTolerance);
 }
 
-bool APDPMultiplayerCharacter::Server_ChangeCameraSideRight_Validate()
+void APDPMultiplayerCharacter::ChangeCameraSideLeft()
 {
-	return true;
+	SetLeftShoulder(true);
 }
 
-void APDPMultiplayerCharacter::Server_ChangeCameraSideRight_Implementation()
+void APDPMultiplayerCharacter::ChangeCameraSideRight()
 {
-	Multicast_ChangeCameraRight();
+	SetLeftShoulder(false);
 }
 
-bool APDPMultiplayerCharacter::Multicast_ChangeCameraRight_Validate()
+void APDPMultiplayerCharacter::SetLeftShoulder(bool bLeftShoulder)
 {
-	return true;
+	ApplyShoulderSide(bLeftShoulder);
+
+	if (GetLocalRole() == ROLE_Authority)
+	{
+		State.bLeftShoulder = bLeftShoulder;
+	}
+	else
+	{
+		Server_SetLeftShoulder(bLeftShoulder);
+	}
 }
 
-void APDPMultiplayerCharacter::Multicast_ChangeCameraRight_Implementation()
+void APDPMultiplayerCharacter::ApplyShoulderSide(bool bLeftShoulder)
 {
+	static const FVector LeftSideCamera = {110.0f, -60.0, 70.0f};
 	static const FVector RightSideCamera = {110.0f, 60.0, 70.0f};
 	
-	FollowCamera->SetRelativeLocation(RightSideCamera);
+	FollowCamera->SetRelativeLocation(bLeftShoulder ? LeftSideCamera : RightSideCamera);
+}
+
+bool APDPMultiplayerCharacter::Server_SetLeftShoulder_Validate(bool bLeftShoulder)
+{
+	return true;
+}
+
+void APDPMultiplayerCharacter::Server_SetLeftShoulder_Implementation(bool bLeftShoulder)
+{
+	if (UPDPNetAccountingSubsystem* NetAccounting = GetWorld()->GetSubsystem<UPDPNetAccountingSubsystem>())
+	{
+		NetAccounting->RecordIncomingRPC(GetNetConnection(), GET_FUNCTION_NAME_CHECKED(APDPMultiplayerCharacter, Server_SetLeftShoulder));
+	}
+
+	State.bLeftShoulder = bLeftShoulder;
+	ApplyShoulderSide(bLeftShoulder);
 }
 
 
@@ -482,6 +820,22 @@ void APDPMultiplayerCharacter::GetLifetimeReplicatedProps(TArray< FLifetimePrope
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(APDPMultiplayerCharacter, Health);
-	DOREPLIFETIME(APDPMultiplayerCharacter, Ammo);
+	DOREPLIFETIME(APDPMultiplayerCharacter, State);
+	DOREPLIFETIME_CONDITION(APDPMultiplayerCharacter, LastConfirmedShotId, COND_OwnerOnly);
+}
+
+bool APDPMultiplayerCharacter::ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags)
+{
+	// The actor channel writes the spawn data and the properties of the character to the bunch right before its subobjects.
+	const int64 BunchBits = Bunch->GetNumBits();
+
+	const bool bWroteSomething = Super::ReplicateSubobjects(Channel, Bunch, RepFlags);
+
+	UPDPNetAccountingSubsystem* NetAccounting = GetWorld()->GetSubsystem<UPDPNetAccountingSubsystem>();
+	if (NetAccounting && NetAccounting->IsEnabled())
+	{
+		NetAccounting->RecordStateReplication(Channel->Connection, this, State, BunchBits);
+	}
+
+	return bWroteSomething;
 }
@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "PDPCharacterState.h"
+#include "PDPReplaySubsystem.h"
 #include "PDPMultiplayerCharacter.generated.h"
 
 DECLARE_DELEGATE_OneParam(FOnAmmoChangedDelegate, const uint8)
@@ -14,6 +16,10 @@ class APDPMultiplayerCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	/** Bots and the network test scenario drive the character through the same input functions as players. */
+	friend class APDPBotController;
+	friend class UPDPNetTestSubsystem;
+
 	/** Camera boom positioning the camera behind the character */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class USpringArmComponent* CameraBoom;
@@ -21,8 +27,16 @@ class APDPMultiplayerCharacter : public ACharacter
 	/** Follow camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UCameraComponent* FollowCamera;
+
+	/** Weapon, tuned by its weapon definition */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Weapon, meta = (AllowPrivateAccess = "true"))
+	class UPDPWeaponComponent* Weapon;
+
+	/** Replication rate, raised by movement, shots and hits */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Replication, meta = (AllowPrivateAccess = "true"))
+	class UPDPNetPolicyComponent* NetPolicy;
 public:
-	APDPMultiplayerCharacter();
+	APDPMultiplayerCharacter(const FObjectInitializer& ObjectInitializer);
 
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
@@ -35,6 +49,24 @@ public:
 	FOnAmmoChangedDelegate OnAmmoChangedDelegate;
 	FOnHealthChangedDelegate OnHealthChangedDelegate;
 
+	/** Puts the character to sleep while it waits in the game mode pawn pool. */
+	void DeactivateForPool();
+
+	/** Brings a pooled character back at SpawnTransform with full health and ammo. */
+	void ResetForRespawn(const FTransform& SpawnTransform);
+
+	/** Stops simulating the ragdoll and keeps its current pose, called by the corpse subsystem. */
+	void FreezeRagdoll();
+
+	/** Queues the damage into the damage subsystem on the server, health changes when the frame's hits are resolved. */
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
+
+	/** Removes the summed damage of a frame from health, called by the damage subsystem. */
+	void ApplyResolvedDamage(float Damage);
+
+	/** Kills the character and schedules its respawn, called by the damage subsystem once all damage of the frame is applied. */
+	void Die(AController* Killer);
+
 protected:
 
 	/** Resets HMD orientation in VR. */
@@ -67,123 +99,148 @@ protected:
 	UFUNCTION(BlueprintCallable)
 	AActor* LineTrace();
 
+	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void PossessedBy(AController* NewController) override;
+	virtual void PawnClientRestart() override;
+
+	/** Also reports State to the network accounting every time the character is replicated to a connection. */
+	virtual bool ReplicateSubobjects(class UActorChannel* Channel, class FOutBunch* Bunch, FReplicationFlags* RepFlags) override;
+
+protected:
+	// Replicated state:
+	UPROPERTY(EditDefaultsOnly, Category= "Character Atributes", meta=(ClampMin = "0", ClampMax = "1023"))
+	float MaxHealth = 100;
+
+	/** Health, ammo, shoulder side and dead flag, replicated as a single bit-packed property. */
+	UPROPERTY(ReplicatedUsing = OnStateChanged)
+	FPDPCharacterState State;
+
+	UFUNCTION()
+	void OnStateChanged(const FPDPCharacterState& PreviousState);
 
 protected:
 	// Take damage:
-	UPROPERTY(ReplicatedUsing = OnHealthChanged, EditDefaultsOnly, Category= "Character Atributes")
-	float Health = 100;
 	bool CanTakeDamage = true;
 
-	UFUNCTION()
-	void OnHealthChanged() const;
-	
-	
-	UFUNCTION(Server, Reliable, WithValidation)
-	void Server_TakeDamage(AActor* DamagedActor, float Damage, const class UDamageType* DamageType, class AController* InstigatedBy, AActor* DamageCauser);
-	bool Server_TakeDamage_Validate(AActor* DamagedActor, float Damage, const class UDamageType* DamageType, class AController* InstigatedBy, AActor* DamageCauser);
-	void Server_TakeDamage_Implementation(AActor* DamagedActor, float Damage, const class UDamageType* DamageType, class AController* InstigatedBy, AActor* DamageCauser);
-
-	UFUNCTION(NetMulticast, Unreliable, WithValidation)
-	void Multicast_Ragdoll();
-	bool Multicast_Ragdoll_Validate();
-	void Multicast_Ragdoll_Implementation();
+	void Ragdoll();
+	void ResetRagdoll();
+
+	/**
+	 * Plays the last seconds of the killer on the owning client while it waits to respawn. The largest reliable
+	 * RPC of the game, accounted with the other outgoing RPCs by the replication graph.
+	 */
+	UFUNCTION(Client, Reliable, WithValidation)
+	void Client_PlayKillCam(const FPDPKillCam& KillCam);
+	bool Client_PlayKillCam_Validate(const FPDPKillCam& KillCam);
+	void Client_PlayKillCam_Implementation(const FPDPKillCam& KillCam);
+
+	/** Mesh and camera placement set up by the Blueprint, restored when the character is reused. */
+	FTransform DefaultMeshRelativeTransform;
+	FName DefaultMeshCollisionProfile;
+	FVector DefaultCameraLocation;
 	
 protected:
 	// Shot:
-	UPROPERTY(ReplicatedUsing = OnAmmoChanged, EditDefaultsOnly, Category= "Character Atributes")
-	uint8 Ammo = 30;
-	
+	/**
+	 * Returns whether the character is alive and its weapon is ready to fire.
+	 * @param FireIntervalTolerance	Seconds the shot may come early, on the server
+	 */
+	bool CanShoot(float FireIntervalTolerance = 0.0f) const;
+
+	/** Ammo shown to the owning client: the replicated ammo minus the shots the server has not confirmed yet. */
+	uint8 PredictedAmmo = 0;
+
+	/** Id of the last shot fired by the owning client. */
+	uint16 LastPredictedShotId = 0;
+
+	/** Ids of the shots that consumed ammo on the owning client and are not confirmed by the server yet. */
+	TArray<uint16> PendingShotIds;
+
+	/** Id of the last shot the server has processed, used by the owning client to reconcile its predicted ammo. */
+	UPROPERTY(ReplicatedUsing = OnLastConfirmedShotIdChanged)
+	uint16 LastConfirmedShotId = 0;
+
 	UFUNCTION()
-	void OnAmmoChanged();
-	
-	bool CanShoot = true;
+	void OnLastConfirmedShotIdChanged();
 
-	UPROPERTY(EditAnywhere, Category= "SFX")
-	USoundBase* Shot;
+	/** Replays the shots still pending on top of the replicated ammo. */
+	void ReconcilePredictedShots();
 
-	UPROPERTY(EditAnywhere, Category= "SFX")
-	USoundBase* NoAmmo;
+	void ResetPredictedShots();
 
-	UPROPERTY(EditAnywhere, Category= "SFX")
-	USoundAttenuation* WeaponSoundAttenuation;
-	
+	/** Called via input to fire from the follow camera. */
+	void Fire();
+
+	/**
+	 * Fires a shot and resolves its hit with lag compensation.
+	 * @param ClientTime	Server world time as seen by the shooter when the shot was fired
+	 * @param ShotId	Sequence id of the shot predicted by the owning client
+	 */
 	UFUNCTION(Server, Reliable, WithValidation)
-	void Server_Shot();
-	bool Server_Shot_Validate();
-	void Server_Shot_Implementation();
+	void Server_Shot(const FVector_NetQuantize& TraceStart, const FVector_NetQuantizeNormal& TraceDirection, float ClientTime, uint16 ShotId);
+	bool Server_Shot_Validate(const FVector_NetQuantize& TraceStart, const FVector_NetQuantizeNormal& TraceDirection, float ClientTime, uint16 ShotId);
+	void Server_Shot_Implementation(const FVector_NetQuantize& TraceStart, const FVector_NetQuantizeNormal& TraceDirection, float ClientTime, uint16 ShotId);
 
-	UFUNCTION(NetMulticast, Reliable, WithValidation)
-	void Multicast_ShotSFX(USoundBase* Sound);
-	bool Multicast_ShotSFX_Validate(USoundBase* Sound);
-	void Multicast_ShotSFX_Implementation(USoundBase* Sound);
+	/**
+	 * Sends the shot sound only to the players within the falloff distance of the weapon sound attenuation.
+	 * The shooter's own client is skipped since it has already played the predicted shot.
+	 */
+	void BroadcastShotSFX(bool bDryFire);
 
+	/** Plays the shot of Shooter on the client owning this character. */
 	UFUNCTION(Client, Unreliable, WithValidation)
-	void Client_TraceOnClient();
-	bool Client_TraceOnClient_Validate();
-	void Client_TraceOnClient_Implementation();
+	void Client_PlayShotSFX(APDPMultiplayerCharacter* Shooter, bool bDryFire);
+	bool Client_PlayShotSFX_Validate(APDPMultiplayerCharacter* Shooter, bool bDryFire);
+	void Client_PlayShotSFX_Implementation(APDPMultiplayerCharacter* Shooter, bool bDryFire);
 
-	UFUNCTION(Server, Reliable, WithValidation)
-	void Server_TraceOnServer();
-	bool Server_TraceOnServer_Validate();
-	void Server_TraceOnServer_Implementation();
+	void PlayShotSFX(bool bDryFire);
 
 protected:
 	// UI:
-	UFUNCTION(Client, Reliable, WithValidation)
-	void Client_DrawUI();
-	bool Client_DrawUI_Validate();
-	void Client_DrawUI_Implementation();
-
-	UFUNCTION(Client, Reliable, WithValidation)
-	void Client_DeleteUI();
-	bool Client_DeleteUI_Validate();
-	void Client_DeleteUI_Implementation();
+	/** Hides the HUD of the owning player, the widget is kept for its next character. */
+	void HideHUD();
 	
 protected:
 	// Change camera side: 
-	UFUNCTION(Server, Unreliable, WithValidation)
-	void Server_ChangeCameraSideLeft();
-	bool Server_ChangeCameraSideLeft_Validate();
-	void Server_ChangeCameraSideLeft_Implementation();
-
-	UFUNCTION(NetMulticast, Unreliable, WithValidation)
-	void Multicast_ChangeCameraLeft();
-	bool Multicast_ChangeCameraLeft_Validate();
-	void Multicast_ChangeCameraLeft_Implementation();
-
-	UFUNCTION(Server, Unreliable, WithValidation)
-	void Server_ChangeCameraSideRight();
-	bool Server_ChangeCameraSideRight_Validate();
-	void Server_ChangeCameraSideRight_Implementation();
-
-	UFUNCTION(NetMulticast, Unreliable, WithValidation)
-	void Multicast_ChangeCameraRight();
-	bool Multicast_ChangeCameraRight_Validate();
-	void Multicast_ChangeCameraRight_Implementation();
+	void ChangeCameraSideLeft();
+	void ChangeCameraSideRight();
+
+	/** Moves the camera locally right away and replicates the side through State. */
+	void SetLeftShoulder(bool bLeftShoulder);
+	void ApplyShoulderSide(bool bLeftShoulder);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void Server_SetLeftShoulder(bool bLeftShoulder);
+	bool Server_SetLeftShoulder_Validate(bool bLeftShoulder);
+	void Server_SetLeftShoulder_Implementation(bool bLeftShoulder);
 
 protected:
 	// APawn interface
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 	// End of APawn interface
 
-private:
-
-	UPROPERTY(EditDefaultsOnly, Category= "Character Atributes", meta=(ClampMin = "0"))
-	uint16 DamageAmount = 20;
-
-	UPROPERTY(EditDefaultsOnly, Category= "Character Atributes", meta=(ClampMin = "0"))
-	float TraceDistance = 30000.0f;
-
 public:
 	/** Returns CameraBoom subobject **/
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+	/** Returns Weapon subobject **/
+	FORCEINLINE class UPDPWeaponComponent* GetWeapon() const { return Weapon; }
+	/** Returns the current health **/
+	FORCEINLINE float GetHealth() const { return State.Health; }
+	/** Returns whether the character has been killed **/
+	FORCEINLINE bool IsDead() const { return State.bDead; }
+	/** Returns the ammo shown to the player, predicted on the owning client **/
+	FORCEINLINE uint8 GetDisplayedAmmo() const { return GetLocalRole() == ROLE_AutonomousProxy ? PredictedAmmo : State.Ammo; }
+	/** Returns the player id of the pawn Actor, INDEX_NONE for other actors and pawns without a player state **/
+	static int32 GetPlayerId(const AActor* Actor);
 
 	//TODO: rework all bellow
 protected:
-	UFUNCTION(BlueprintImplementableEvent)
+	/** Blueprint scoring, only called while the killer's player state is not an APDPPlayerState. */
+	UFUNCTION(BlueprintImplementableEvent, meta=(DeprecatedFunction, DeprecationMessage="Scoring moved to APDPPlayerState, remove the event once PDP_PlayerState derives from it."))
 	void AddScore(AController* InstigatedBy);
 
 	UFUNCTION(BlueprintImplementableEvent)
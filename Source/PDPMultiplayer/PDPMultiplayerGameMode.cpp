@@ -2,8 +2,14 @@
 
 #include "PDPMultiplayerGameMode.h"
 
+#include "PDPBotController.h"
+#include "PDPGameState.h"
+#include "PDPLoadTestSubsystem.h"
+#include "PDPMultiplayer.h"
 #include "PDPMultiplayerCharacter.h"
-#include "Kismet/GameplayStatics.h"
+#include "PDPPlayerState.h"
+#include "PDPSpawnPointSubsystem.h"
+#include "Misc/CommandLine.h"
 #include "UObject/ConstructorHelpers.h"
 
 APDPMultiplayerGameMode::APDPMultiplayerGameMode()
@@ -14,15 +20,147 @@ APDPMultiplayerGameMode::APDPMultiplayerGameMode()
 	{
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
+
+	GameStateClass = APDPGameState::StaticClass();
+	PlayerStateClass = APDPPlayerState::StaticClass();
+
+	BotControllerClass = APDPBotController::StaticClass();
+
+	// Map changes keep the connections, player controllers and player states, through an empty transition world.
+	bUseSeamlessTravel = true;
+}
+
+void APDPMultiplayerGameMode::StartPlay()
+{
+	// Pre-warm the pool before the players get their first pawn.
+	const FTransform PooledTransform(PooledPawnLocation);
+	for (int32 Index = PawnPool.Num(); Index < PawnPoolSize; ++Index)
+	{
+		APDPMultiplayerCharacter* Character = SpawnCharacter(PooledTransform);
+		if (!Character)
+		{
+			break;
+		}
+
+		ReleasePawn(Character);
+	}
+
+	Super::StartPlay();
+
+	// -PDPBots=N fills the match with bots, -PDPLoadTest runs the load test and exits.
+	int32 NumBots = 0;
+	if (FParse::Value(FCommandLine::Get(), TEXT("PDPBots="), NumBots))
+	{
+		SpawnBots(NumBots);
+	}
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("PDPLoadTest")))
+	{
+		if (UPDPLoadTestSubsystem* LoadTest = GetWorld()->GetSubsystem<UPDPLoadTestSubsystem>())
+		{
+			LoadTest->StartLoadTest(true);
+		}
+	}
+}
+
+APawn* APDPMultiplayerGameMode::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	if (!DefaultPawnClass || !DefaultPawnClass->IsChildOf<APDPMultiplayerCharacter>())
+	{
+		return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
+	}
+
+	return AcquirePawn(SpawnTransform);
+}
+
+APDPMultiplayerCharacter* APDPMultiplayerGameMode::SpawnCharacter(const FTransform& SpawnTransform)
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return nullptr;
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParameters.ObjectFlags |= RF_Transient;
+
+	return Cast<APDPMultiplayerCharacter>(World->SpawnActor(DefaultPawnClass, &SpawnTransform, SpawnParameters));
+}
+
+APDPMultiplayerCharacter* APDPMultiplayerGameMode::AcquirePawn(const FTransform& SpawnTransform)
+{
+	while (PawnPool.Num() > 0)
+	{
+		APDPMultiplayerCharacter* Character = PawnPool.Pop(false);
+		if (IsValid(Character))
+		{
+			Character->ResetForRespawn(SpawnTransform);
+			return Character;
+		}
+	}
+
+	return SpawnCharacter(SpawnTransform);
+}
+
+void APDPMultiplayerGameMode::ReleasePawn(APDPMultiplayerCharacter* Character)
+{
+	Character->DeactivateForPool();
+	Character->SetActorLocation(PooledPawnLocation, false, nullptr, ETeleportType::ResetPhysics);
+
+	PawnPool.Push(Character);
+}
+
+void APDPMultiplayerGameMode::SpawnBots(int32 Count)
+{
+	UWorld* World = GetWorld();
+	if (!World || !BotControllerClass)
+	{
+		return;
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParameters.ObjectFlags |= RF_Transient;
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		APDPBotController* Bot = World->SpawnActor<APDPBotController>(BotControllerClass, SpawnParameters);
+		if (!Bot)
+		{
+			return;
+		}
+
+		Bots.Add(Bot);
+
+		// Without a pawn, Respawn only picks a start and possesses a pooled character.
+		Respawn(Bot);
+	}
 }
 
 void APDPMultiplayerGameMode::Respawn(AController* Controller)
 {
+	PDP_SCOPE_CYCLE_COUNTER(STAT_PDP_Respawn, Respawn);
+	PDP_INC_COUNTER(STAT_PDP_Respawns, Respawns, 1);
+
 	APawn* Pawn = Controller->GetPawn();
 
 	if (IsValid(Pawn))
 	{
-		Pawn->Destroy();
+		Controller->UnPossess();
+
+		// Dead characters stay in the world as corpses until the corpse subsystem evicts them.
+		if (APDPMultiplayerCharacter* Character = Cast<APDPMultiplayerCharacter>(Pawn))
+		{
+			if (!Character->IsDead())
+			{
+				ReleasePawn(Character);
+			}
+		}
+		else
+		{
+			Pawn->Destroy();
+		}
 	}
 	
 	UWorld* World = GetWorld();
@@ -31,10 +169,40 @@ void APDPMultiplayerGameMode::Respawn(AController* Controller)
 		return;
 	}
 	
-	TArray<AActor*> PlayerStarts;
-	UGameplayStatics::GetAllActorsOfClass(World, APlayerStart::StaticClass(), PlayerStarts);
+	UPDPSpawnPointSubsystem* SpawnPoints = World->GetSubsystem<UPDPSpawnPointSubsystem>();
+
+	// Without any player start the engine falls back to the world settings location.
+	const AActor* SpawnPoint = SpawnPoints ? SpawnPoints->ChooseSpawnPoint(Controller) : nullptr;
+	if (!SpawnPoint)
+	{
+		SpawnPoint = FindPlayerStart(Controller);
+	}
 
-	const APlayerStart* RandomPlayerStart = Cast<APlayerStart>(PlayerStarts[FMath::RandHelper(PlayerStarts.Num())]);
+	if (!SpawnPoint)
+	{
+		return;
+	}
 	
-	Controller->Possess(Cast<APDPMultiplayerCharacter>(World->SpawnActor(DefaultPawnClass, &RandomPlayerStart->GetTransform(), FActorSpawnParameters())));
+	if (APDPMultiplayerCharacter* Character = AcquirePawn(SpawnPoint->GetTransform()))
+	{
+		Controller->Possess(Character);
+	}
+}
+
+void APDPMultiplayerGameMode::ScoreKill(AController* Killer, AController* Victim)
+{
+	if (APDPPlayerState* VictimState = Victim ? Victim->GetPlayerState<APDPPlayerState>() : nullptr)
+	{
+		VictimState->AddDeath();
+	}
+
+	if (Killer == Victim)
+	{
+		return;
+	}
+
+	if (APDPPlayerState* KillerState = Killer ? Killer->GetPlayerState<APDPPlayerState>() : nullptr)
+	{
+		KillerState->AddKill(KillScore);
+	}
 }
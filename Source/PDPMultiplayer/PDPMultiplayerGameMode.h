@@ -8,7 +8,9 @@
 #include "PDPMultiplayerCharacter.h"
 #include "PDPMultiplayerGameMode.generated.h"
 
-UCLASS(minimalapi)
+class APDPBotController;
+
+UCLASS(minimalapi, config=Game)
 class APDPMultiplayerGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
@@ -16,7 +18,53 @@ class APDPMultiplayerGameMode : public AGameModeBase
 public:
 	APDPMultiplayerGameMode();
 
+	virtual void StartPlay() override;
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override;
+
 	void Respawn(AController* Controller);
+
+	/** Puts a character back in the pool, used for living characters on respawn and for evicted corpses. */
+	void ReleasePawn(APDPMultiplayerCharacter* Character);
+
+	/** Adds Count load-testing bots to the match, each with its own character. */
+	void SpawnBots(int32 Count);
+
+	FORCEINLINE int32 GetNumBots() const { return Bots.Num(); }
+
+	/** Counts the death of Victim and, unless it killed itself, the kill of Killer. */
+	void ScoreKill(AController* Killer, AController* Victim);
+
+protected:
+	// Pawn pool:
+	/** Number of characters spawned into the pool when the match starts. */
+	UPROPERTY(config, EditDefaultsOnly, Category= "Pawn Pool", meta=(ClampMin = "0"))
+	int32 PawnPoolSize = 16;
+
+	/** Where pooled characters wait, hidden and without collision. */
+	UPROPERTY(config, EditDefaultsOnly, Category= "Pawn Pool")
+	FVector PooledPawnLocation = FVector(0.0f, 0.0f, -50000.0f);
+
+	/** Takes a character from the pool, or spawns a new one if the pool is empty. */
+	APDPMultiplayerCharacter* AcquirePawn(const FTransform& SpawnTransform);
+
+protected:
+	// Score:
+	UPROPERTY(config, EditDefaultsOnly, Category= "Score")
+	float KillScore = 1.0f;
+
+protected:
+	// Bots:
+	UPROPERTY(EditDefaultsOnly, Category= "Bots")
+	TSubclassOf<APDPBotController> BotControllerClass;
+
+private:
+	APDPMultiplayerCharacter* SpawnCharacter(const FTransform& SpawnTransform);
+
+	UPROPERTY()
+	TArray<APDPMultiplayerCharacter*> PawnPool;
+
+	UPROPERTY()
+	TArray<APDPBotController*> Bots;
 };
 
 
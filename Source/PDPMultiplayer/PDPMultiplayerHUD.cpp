@@ -3,23 +3,42 @@
 
 #include "PDPMultiplayerHUD.h"
 
+#include "PDPMultiplayerCharacter.h"
+#include "PDPMultiplayerHUDWidget.h"
 #include "Blueprint/UserWidget.h"
 
 void APDPMultiplayerHUD::DrawIU()
 {
-	HUDWidget = CreateWidget(PlayerOwner, HUD);
-	if (HUDWidget)
-	{
-		HUDWidget->AddToViewport();
-	}
+	ShowForCharacter(Cast<APDPMultiplayerCharacter>(GetOwningPawn()));
 }
 
 void APDPMultiplayerHUD::DeleteUI()
 {
 	if (IsValid(HUDWidget))
 	{
-		HUDWidget->RemoveFromParent();
+		HUDWidget->SetVisibility(ESlateVisibility::Collapsed);
+	}
+}
+
+void APDPMultiplayerHUD::ShowForCharacter(APDPMultiplayerCharacter* Character)
+{
+#if !UE_SERVER
+	if (!IsValid(HUDWidget))
+	{
+		HUDWidget = CreateWidget(PlayerOwner, HUD);
+		if (!HUDWidget)
+		{
+			return;
+		}
+
+		HUDWidget->AddToViewport();
 	}
-	
-	HUDWidget = nullptr;
+
+	if (UPDPMultiplayerHUDWidget* CharacterWidget = Cast<UPDPMultiplayerHUDWidget>(HUDWidget))
+	{
+		CharacterWidget->SetCharacter(Character);
+	}
+
+	HUDWidget->SetVisibility(ESlateVisibility::SelfHitTestInvisible);
+#endif
 }
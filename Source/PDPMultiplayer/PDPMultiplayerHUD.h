@@ -6,8 +6,11 @@
 #include "GameFramework/HUD.h"
 #include "PDPMultiplayerHUD.generated.h"
 
+class APDPMultiplayerCharacter;
+
 /**
- * 
+ * Owns the HUD widget of its player controller. The widget is created the first time a character
+ * is possessed and then only hidden and shown again, bound to each new character, across respawns.
  */
 UCLASS()
 class PDPMULTIPLAYER_API APDPMultiplayerHUD : public AHUD
@@ -15,12 +18,17 @@ class PDPMULTIPLAYER_API APDPMultiplayerHUD : public AHUD
 	GENERATED_BODY()
 	
 public:
+	/** Shows the HUD widget for the pawn of the owning player. */
 	UFUNCTION(BlueprintCallable)
 	void DrawIU();
 	
+	/** Hides the HUD widget, it is kept for the next character. */
 	UFUNCTION(BlueprintCallable)
 	void DeleteUI();
 
+	/** Shows the HUD widget bound to Character, creating it on first use. */
+	void ShowForCharacter(APDPMultiplayerCharacter* Character);
+
 protected:
 	UPROPERTY(EditDefaultsOnly)
 	TSubclassOf<UUserWidget> HUD;
@@ -2,26 +2,119 @@
 
 
 #include "PDPMultiplayerHUDWidget.h"
+#include "PDPCharacterState.h"
+#include "PDPMultiplayer.h"
 #include "PDPMultiplayerCharacter.h"
 #include "Components/TextBlock.h"
+#include "HAL/IConsoleManager.h"
+
+static FAutoConsoleCommand HUDBenchmarkCommand(
+	TEXT("PDP.HUD.Benchmark"),
+	TEXT("Logs the cost of building the HUD number texts on every update against the cached ones. Usage: PDP.HUD.Benchmark [Iterations]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const int32 NumIterations = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+
+		// Warms the cache up, it is built once per process.
+		UPDPMultiplayerHUDWidget::GetNumberText(0);
+
+		int32 NumCharacters = 0;
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumIterations; ++Index)
+		{
+			NumCharacters += FText::FromString(FString::FromInt(Index % FPDPCharacterState::MaxNetHealth)).ToString().Len();
+		}
+		const double FormattedNs = (FPlatformTime::Seconds() - StartTime) * 1.0e9 / NumIterations;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumIterations; ++Index)
+		{
+			NumCharacters += UPDPMultiplayerHUDWidget::GetNumberText(Index % FPDPCharacterState::MaxNetHealth).ToString().Len();
+		}
+		const double CachedNs = (FPlatformTime::Seconds() - StartTime) * 1.0e9 / NumIterations;
+
+		UE_LOG(LogPDPMultiplayer, Display, TEXT("HUD benchmark: %d updates, formatted %.1f ns, cached %.1f ns per update (%d characters)"), NumIterations, FormattedNs, CachedNs, NumCharacters);
+	}));
+
+FText UPDPMultiplayerHUDWidget::GetNumberText(int32 Value)
+{
+	static TArray<FText> NumberTexts;
+	if (NumberTexts.Num() == 0)
+	{
+		NumberTexts.Reserve(FPDPCharacterState::MaxNetHealth + 1);
+		for (int32 Index = 0; Index <= FPDPCharacterState::MaxNetHealth; ++Index)
+		{
+			NumberTexts.Add(FText::AsCultureInvariant(FString::FromInt(Index)));
+		}
+	}
+
+	return NumberTexts.IsValidIndex(Value) ? NumberTexts[Value] : FText::AsCultureInvariant(FString::FromInt(Value));
+}
 
 void UPDPMultiplayerHUDWidget::NativeConstruct()
 {
 	Super::NativeConstruct();
 
-	if(APDPMultiplayerCharacter* Player = Cast<APDPMultiplayerCharacter>(GetOwningPlayer()->GetPawn()))
+	if (!Character.IsValid())
+	{
+		SetCharacter(Cast<APDPMultiplayerCharacter>(GetOwningPlayerPawn()));
+	}
+}
+
+void UPDPMultiplayerHUDWidget::NativeDestruct()
+{
+	SetCharacter(nullptr);
+
+	Super::NativeDestruct();
+}
+
+void UPDPMultiplayerHUDWidget::SetCharacter(APDPMultiplayerCharacter* NewCharacter)
+{
+	// Characters go back to the pawn pool and may be possessed by someone else next.
+	if (APDPMultiplayerCharacter* OldCharacter = Character.Get())
 	{
-		Player->OnHealthChangedDelegate.BindUObject(this, &UPDPMultiplayerHUDWidget::UpdateHealth);
-		Player->OnAmmoChangedDelegate.BindUObject(this, &UPDPMultiplayerHUDWidget::UpdateAmmo);
+		OldCharacter->OnHealthChangedDelegate.Unbind();
+		OldCharacter->OnAmmoChangedDelegate.Unbind();
 	}
+
+	Character = NewCharacter;
+
+	if (!NewCharacter)
+	{
+		return;
+	}
+
+	NewCharacter->OnHealthChangedDelegate.BindUObject(this, &UPDPMultiplayerHUDWidget::UpdateHealth);
+	NewCharacter->OnAmmoChangedDelegate.BindUObject(this, &UPDPMultiplayerHUDWidget::UpdateAmmo);
+
+	UpdateHealth(NewCharacter->GetHealth());
+	UpdateAmmo(NewCharacter->GetDisplayedAmmo());
 }
 
 void UPDPMultiplayerHUDWidget::UpdateHealth(const float NewHealth)
 {
-	HealthText->SetText(FText::FromString(FString::FromInt(static_cast<int>(NewHealth))));
+	PDP_SCOPE_CYCLE_COUNTER(STAT_PDP_HUDUpdate, HUDUpdate);
+
+	const int32 Health = static_cast<int32>(NewHealth);
+	if (Health == DisplayedHealth)
+	{
+		return;
+	}
+
+	DisplayedHealth = Health;
+	HealthText->SetText(GetNumberText(Health));
 }
 
 void UPDPMultiplayerHUDWidget::UpdateAmmo(const uint8 NewAmmo)
 {
-	AmmoText->SetText(FText::FromString(FString::FromInt(NewAmmo)));
+	PDP_SCOPE_CYCLE_COUNTER(STAT_PDP_HUDUpdate, HUDUpdate);
+
+	if (NewAmmo == DisplayedAmmo)
+	{
+		return;
+	}
+
+	DisplayedAmmo = NewAmmo;
+	AmmoText->SetText(GetNumberText(NewAmmo));
 }
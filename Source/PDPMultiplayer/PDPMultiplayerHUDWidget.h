@@ -6,17 +6,28 @@
 #include "Blueprint/UserWidget.h"
 #include "PDPMultiplayerHUDWidget.generated.h"
 
+class APDPMultiplayerCharacter;
 class UTextBlock;
 /**
- * 
+ * Health and ammo of the possessed character. The texts are only set when the displayed number changes,
+ * from a table of texts built once for every value that can be replicated, so an update never allocates.
+ * The widget outlives the characters, the HUD binds it to each new one.
  */
 UCLASS()
 class PDPMULTIPLAYER_API UPDPMultiplayerHUDWidget : public UUserWidget
 {
 	GENERATED_BODY()
 	
+public:
+	/** Text of Value, for 0 to the highest replicated health. Other values are formatted on the fly. */
+	static FText GetNumberText(int32 Value);
+
+	/** Follows the health and ammo of Character instead of the previous one, and shows its current values. */
+	void SetCharacter(APDPMultiplayerCharacter* NewCharacter);
+
 protected:
 	virtual void NativeConstruct() override;
+	virtual void NativeDestruct() override;
 
 	void UpdateHealth(const float NewHealth);
 	void UpdateAmmo(const uint8 NewAmmo);
@@ -26,4 +37,10 @@ protected:
 
 	UPROPERTY(BlueprintReadWrite, meta=(BindWidget))
 	UTextBlock* AmmoText;
+
+private:
+	TWeakObjectPtr<APDPMultiplayerCharacter> Character;
+
+	int32 DisplayedHealth = INDEX_NONE;
+	int32 DisplayedAmmo = INDEX_NONE;
 };
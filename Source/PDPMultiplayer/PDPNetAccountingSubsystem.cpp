@@ -0,0 +1,282 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPNetAccountingSubsystem.h"
+
+#include "PDPMultiplayer.h"
+#include "PDPMultiplayerCharacter.h"
+#include "Async/Async.h"
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static int32 GNetAccountingEnable = UE_SERVER;
+static FAutoConsoleVariableRef CVarNetAccountingEnable(
+	TEXT("PDP.NetAccounting.Enable"),
+	GNetAccountingEnable,
+	TEXT("Count the RPCs and state changes sent to and received from every connection and write them to a CSV file. Server only, on by default in the server target."),
+	ECVF_Default);
+
+static float GNetAccountingFlushInterval = 10.0f;
+static FAutoConsoleVariableRef CVarNetAccountingFlushInterval(
+	TEXT("PDP.NetAccounting.FlushInterval"),
+	GNetAccountingFlushInterval,
+	TEXT("Seconds between two rows of the network accounting CSV file."),
+	ECVF_Default);
+
+static int32 GNetAccountingMaxFileSize = 16 * 1024 * 1024;
+static FAutoConsoleVariableRef CVarNetAccountingMaxFileSize(
+	TEXT("PDP.NetAccounting.MaxFileSize"),
+	GNetAccountingMaxFileSize,
+	TEXT("Bytes after which the network accounting starts a new CSV file."),
+	ECVF_Default);
+
+static int32 GNetAccountingMaxFiles = 4;
+static FAutoConsoleVariableRef CVarNetAccountingMaxFiles(
+	TEXT("PDP.NetAccounting.MaxFiles"),
+	GNetAccountingMaxFiles,
+	TEXT("Network accounting CSV files kept on disk, the oldest one is deleted when a new one is started."),
+	ECVF_Default);
+
+static const TCHAR* NetAccountingHeader = TEXT("Time,Connection,Direction,Name,Calls,Bits,Drops,MaxReliableBuffer\n");
+
+void UPDPNetAccountingSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const UWorld* World = GetWorld();
+	if (!World || !World->IsGameWorld())
+	{
+		return;
+	}
+
+	FileBaseName = FPaths::ProfilingDir() / TEXT("NetAccounting") / FString::Printf(TEXT("PDPNetAccounting-%s"), *FDateTime::Now().ToString());
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UPDPNetAccountingSubsystem::OnWorldPostActorTick);
+}
+
+void UPDPNetAccountingSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+	// The last counters are written before the world goes away.
+	if (!FileBaseName.IsEmpty())
+	{
+		Flush(true);
+	}
+
+	Connections.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UPDPNetAccountingSubsystem::IsEnabled() const
+{
+	const UWorld* World = GetWorld();
+	return GNetAccountingEnable != 0 && !FileBaseName.IsEmpty() && World && (World->GetNetMode() == NM_DedicatedServer || World->GetNetMode() == NM_ListenServer);
+}
+
+void UPDPNetAccountingSubsystem::RecordOutgoingRPC(UNetConnection* Connection, FName FunctionName, int64 Bits, bool bDropped, int32 ReliableBuffer)
+{
+	FConnectionAccounting* Accounting = FindOrAddConnection(Connection);
+	if (!Accounting)
+	{
+		return;
+	}
+
+	FEntry& Entry = Accounting->Entries.FindOrAdd(FunctionName);
+	++Entry.Calls;
+	Entry.Bits += Bits;
+	Entry.Drops += bDropped ? 1 : 0;
+	Entry.MaxReliableBuffer = FMath::Max(Entry.MaxReliableBuffer, ReliableBuffer);
+}
+
+void UPDPNetAccountingSubsystem::RecordIncomingRPC(UNetConnection* Connection, FName FunctionName)
+{
+	FConnectionAccounting* Accounting = FindOrAddConnection(Connection);
+	if (!Accounting)
+	{
+		return;
+	}
+
+	FEntry& Entry = Accounting->Entries.FindOrAdd(FunctionName);
+	Entry.bIncoming = true;
+	++Entry.Calls;
+}
+
+void UPDPNetAccountingSubsystem::RecordStateReplication(UNetConnection* Connection, const APDPMultiplayerCharacter* Character, const FPDPCharacterState& State, int64 BunchBits)
+{
+	static const FName BunchName(TEXT("Bunch"));
+	static const FName HealthName(TEXT("State.Health"));
+	static const FName AmmoName(TEXT("State.Ammo"));
+	static const FName StateName(TEXT("State"));
+
+	FConnectionAccounting* Accounting = FindOrAddConnection(Connection);
+	if (!Accounting)
+	{
+		return;
+	}
+
+	if (BunchBits > 0)
+	{
+		FEntry& Entry = Accounting->Entries.FindOrAdd(BunchName);
+		++Entry.Calls;
+		Entry.Bits += BunchBits;
+	}
+
+	// The first replication to a connection sends the whole state.
+	const FPDPCharacterState* LastSentState = Accounting->LastSentStates.Find(Character);
+
+	// Health is compared the way it is quantized, changes below one point are never sent.
+	const bool bHealthChanged = !LastSentState || FMath::CeilToInt(LastSentState->Health) != FMath::CeilToInt(State.Health);
+	const bool bAmmoChanged = !LastSentState || LastSentState->Ammo != State.Ammo;
+	const bool bFlagsChanged = !LastSentState || LastSentState->bDead != State.bDead || LastSentState->bLeftShoulder != State.bLeftShoulder;
+
+	if (!bHealthChanged && !bAmmoChanged && !bFlagsChanged)
+	{
+		return;
+	}
+
+	if (bHealthChanged)
+	{
+		FEntry& Entry = Accounting->Entries.FindOrAdd(HealthName);
+		++Entry.Calls;
+	}
+
+	if (bAmmoChanged)
+	{
+		// Every shot takes one round, the rounds missing from the difference were never sent.
+		FEntry& Entry = Accounting->Entries.FindOrAdd(AmmoName);
+		++Entry.Calls;
+		Entry.Drops += LastSentState ? FMath::Max(FMath::Abs(LastSentState->Ammo - State.Ammo) - 1, 0) : 0;
+	}
+
+	// State is serialized as a whole whatever changed in it.
+	FEntry& Entry = Accounting->Entries.FindOrAdd(StateName);
+	++Entry.Calls;
+	Entry.Bits += FPDPCharacterState::NetBits;
+
+	Accounting->LastSentStates.Add(Character, State);
+}
+
+UPDPNetAccountingSubsystem::FConnectionAccounting* UPDPNetAccountingSubsystem::FindOrAddConnection(UNetConnection* Connection)
+{
+	if (!Connection || !IsEnabled())
+	{
+		return nullptr;
+	}
+
+	if (FConnectionAccounting* Accounting = Connections.Find(Connection))
+	{
+		return Accounting;
+	}
+
+	FConnectionAccounting& Accounting = Connections.Add(Connection);
+	Accounting.Name = Connection->LowLevelGetRemoteAddress(true);
+	return &Accounting;
+}
+
+void UPDPNetAccountingSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || !IsEnabled())
+	{
+		return;
+	}
+
+	const double Now = World->GetRealTimeSeconds();
+	if (Now < NextFlushTime)
+	{
+		return;
+	}
+
+	NextFlushTime = Now + FMath::Max(GNetAccountingFlushInterval, 1.0f);
+	Flush(false);
+}
+
+void UPDPNetAccountingSubsystem::Flush(bool bWait)
+{
+	const FString Time = FDateTime::UtcNow().ToIso8601();
+
+	for (auto ConnectionIt = Connections.CreateIterator(); ConnectionIt; ++ConnectionIt)
+	{
+		if (!ConnectionIt.Key().IsValid())
+		{
+			ConnectionIt.RemoveCurrent();
+			continue;
+		}
+
+		FConnectionAccounting& Accounting = ConnectionIt.Value();
+		for (const TPair<FName, FEntry>& Entry : Accounting.Entries)
+		{
+			PendingRows += FString::Printf(TEXT("%s,%s,%s,%s,%u,%llu,%u,%d\n"),
+				*Time, *Accounting.Name, Entry.Value.bIncoming ? TEXT("In") : TEXT("Out"), *Entry.Key.ToString(),
+				Entry.Value.Calls, Entry.Value.Bits, Entry.Value.Drops, Entry.Value.MaxReliableBuffer);
+		}
+
+		Accounting.Entries.Reset();
+
+		for (auto StateIt = Accounting.LastSentStates.CreateIterator(); StateIt; ++StateIt)
+		{
+			if (!StateIt.Key().IsValid())
+			{
+				StateIt.RemoveCurrent();
+			}
+		}
+	}
+
+	if (PendingRows.IsEmpty())
+	{
+		return;
+	}
+
+	// A slow disk never stalls the game thread, the rows wait for the next flush instead.
+	if (WriteFuture.IsValid() && !WriteFuture.IsReady())
+	{
+		if (!bWait)
+		{
+			return;
+		}
+
+		WriteFuture.Wait();
+	}
+
+	if (FileSize >= GNetAccountingMaxFileSize)
+	{
+		++FileIndex;
+		FileSize = 0;
+	}
+
+	FString ExpiredFilePath;
+	if (FileSize == 0)
+	{
+		PendingRows.InsertAt(0, NetAccountingHeader);
+
+		if (FileIndex >= GNetAccountingMaxFiles)
+		{
+			ExpiredFilePath = FString::Printf(TEXT("%s-%d.csv"), *FileBaseName, FileIndex - GNetAccountingMaxFiles);
+		}
+	}
+
+	const FString FilePath = FString::Printf(TEXT("%s-%d.csv"), *FileBaseName, FileIndex);
+	FileSize += PendingRows.Len();
+
+	WriteFuture = Async(EAsyncExecution::ThreadPool, [Rows = MoveTemp(PendingRows), FilePath, ExpiredFilePath]()
+	{
+		FFileHelper::SaveStringToFile(Rows, *FilePath, FFileHelper::EEncodingOptions::ForceAnsi, &IFileManager::Get(), FILEWRITE_Append);
+
+		if (!ExpiredFilePath.IsEmpty())
+		{
+			IFileManager::Get().Delete(*ExpiredFilePath, false, false, true);
+		}
+	});
+
+	PendingRows.Reset();
+
+	if (bWait)
+	{
+		WriteFuture.Wait();
+	}
+}
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "PDPCharacterState.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PDPNetAccountingSubsystem.generated.h"
+
+class APDPMultiplayerCharacter;
+class UNetConnection;
+
+/**
+ * Server-side network accounting, per connection: calls, bits, drops and reliable buffer usage of every RPC,
+ * and the replication of the characters. Counters are appended to a rolling CSV file in the profiling
+ * directory every PDP.NetAccounting.FlushInterval seconds; the file is written on a worker thread.
+ * On by default in the server target only, PIE and game builds turn it on with PDP.NetAccounting.Enable.
+ *
+ * Outgoing RPCs are measured where the replication graph sends them. Incoming RPCs only count calls, their
+ * Bits column is 0. Character rows:
+ *	Bunch			Bits of the character bunch before its subobjects: the spawn and NetGUID data when the
+ *					channel opens, the content block headers and every property, State included.
+ *	State			Bits of the serialized state.
+ *	State.Health	State.Ammo	Changes sent, Bits 0 as they are part of State. Drops are the values
+ *					overwritten before they could be sent.
+ */
+UCLASS()
+class PDPMULTIPLAYER_API UPDPNetAccountingSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	bool IsEnabled() const;
+
+	/**
+	 * @param Bits	Bits added to the connection send buffer, bunch header included
+	 * @param ReliableBuffer	Reliable bunches of the actor channel waiting for an ack after the call
+	 */
+	void RecordOutgoingRPC(UNetConnection* Connection, FName FunctionName, int64 Bits, bool bDropped, int32 ReliableBuffer);
+	void RecordIncomingRPC(UNetConnection* Connection, FName FunctionName);
+
+	/**
+	 * Called every time Character replicates to Connection, counts the state fields that changed since the last time.
+	 * @param BunchBits	Bits written to the bunch of the character before its subobjects
+	 */
+	void RecordStateReplication(UNetConnection* Connection, const APDPMultiplayerCharacter* Character, const FPDPCharacterState& State, int64 BunchBits);
+
+private:
+	struct FEntry
+	{
+		bool bIncoming = false;
+		uint32 Calls = 0;
+		uint64 Bits = 0;
+		uint32 Drops = 0;
+		int32 MaxReliableBuffer = 0;
+	};
+
+	struct FConnectionAccounting
+	{
+		FString Name;
+		TMap<FName, FEntry> Entries;
+		TMap<TWeakObjectPtr<const APDPMultiplayerCharacter>, FPDPCharacterState> LastSentStates;
+	};
+
+	FConnectionAccounting* FindOrAddConnection(UNetConnection* Connection);
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void Flush(bool bWait);
+
+	TMap<TWeakObjectPtr<UNetConnection>, FConnectionAccounting> Connections;
+
+	double NextFlushTime = 0.0;
+
+	/** Rows not written yet, kept while the previous write is still running. */
+	FString PendingRows;
+
+	FString FileBaseName;
+	int32 FileIndex = 0;
+	int64 FileSize = 0;
+
+	TFuture<void> WriteFuture;
+
+	FDelegateHandle PostActorTickHandle;
+};
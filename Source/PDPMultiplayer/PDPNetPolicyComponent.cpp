@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPNetPolicyComponent.h"
+
+#include "PDPReplicationGraph.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+static int32 GNetPolicyEnable = 1;
+static FAutoConsoleVariableRef CVarNetPolicyEnable(
+	TEXT("PDP.NetPolicy.Enable"),
+	GNetPolicyEnable,
+	TEXT("Replicate characters by activity and distance. When disabled, every character replicates at its active rate."),
+	ECVF_Default);
+
+UPDPNetPolicyComponent::UPDPNetPolicyComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	// The viewer distances and the activity don't need more, shots and hits are applied right away.
+	PrimaryComponentTick.TickInterval = 0.25f;
+}
+
+void UPDPNetPolicyComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetPolicyEnabled(GetOwnerRole() == ROLE_Authority);
+}
+
+void UPDPNetPolicyComponent::SetPolicyEnabled(bool bEnabled)
+{
+	const bool bAuthority = GetOwnerRole() == ROLE_Authority;
+	SetComponentTickEnabled(bEnabled && bAuthority);
+
+	if (bEnabled && bAuthority)
+	{
+		Activity = 1.0f;
+		ApplyPolicy();
+	}
+}
+
+void UPDPNetPolicyComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const AActor* Owner = GetOwner();
+	if (!Owner)
+	{
+		return;
+	}
+
+	Activity = FMath::Max(Activity - DeltaTime / ActivityDecayTime, 0.0f);
+
+	if (Owner->GetVelocity().SizeSquared() > FMath::Square(MinMovingSpeed))
+	{
+		Activity = FMath::Max(Activity, MovingActivity);
+	}
+
+	ApplyPolicy();
+}
+
+void UPDPNetPolicyComponent::NotifyActivity()
+{
+	if (!IsComponentTickEnabled())
+	{
+		return;
+	}
+
+	// Already at full rate, the next tick refreshes the viewer distances.
+	const bool bWasActive = Activity >= 1.0f;
+	Activity = 1.0f;
+
+	if (!bWasActive)
+	{
+		ApplyPolicy();
+	}
+}
+
+void UPDPNetPolicyComponent::ApplyPolicy()
+{
+	AActor* Owner = GetOwner();
+	UWorld* World = GetWorld();
+	if (!Owner || !World)
+	{
+		return;
+	}
+
+	const float Alpha = GNetPolicyEnable ? Activity : 1.0f;
+	Owner->NetUpdateFrequency = FMath::Lerp(IdleNetUpdateFrequency, ActiveNetUpdateFrequency, Alpha);
+	Owner->NetPriority = FMath::Lerp(IdleNetPriority, ActiveNetPriority, Alpha);
+
+	// The replication graph only reads the class defaults, the new rate is pushed to it.
+	UNetDriver* NetDriver = World->GetNetDriver();
+	if (UPDPReplicationGraph* ReplicationGraph = NetDriver ? NetDriver->GetReplicationDriver<UPDPReplicationGraph>() : nullptr)
+	{
+		ReplicationGraph->SetActorReplicationRate(Owner, Owner->NetUpdateFrequency, Owner->NetPriority, GNetPolicyEnable != 0);
+	}
+}
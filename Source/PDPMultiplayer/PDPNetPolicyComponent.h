@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "PDPNetPolicyComponent.generated.h"
+
+/**
+ * Replication rate of the owner, driven by what it does. Firing and taking damage set the activity to full,
+ * moving keeps it at MovingActivity, and it decays to idle over ActivityDecayTime. The net update frequency
+ * and priority of the owner go from their idle to their active values with the activity; the replication
+ * graph further slows the owner down for the viewers far from it. Server only.
+ */
+UCLASS(ClassGroup=(PDP), meta=(BlueprintSpawnableComponent))
+class PDPMULTIPLAYER_API UPDPNetPolicyComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UPDPNetPolicyComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Sets the activity to full, for a shot or a hit. */
+	void NotifyActivity();
+
+	/** Starts a new life at full activity, or stops updating the owner while it is pooled. */
+	void SetPolicyEnabled(bool bEnabled);
+
+	FORCEINLINE float GetActivity() const { return Activity; }
+
+protected:
+	virtual void BeginPlay() override;
+
+	UPROPERTY(EditDefaultsOnly, Category= "Net Policy", meta=(ClampMin = "1"))
+	float IdleNetUpdateFrequency = 10.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category= "Net Policy", meta=(ClampMin = "1"))
+	float ActiveNetUpdateFrequency = 100.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category= "Net Policy", meta=(ClampMin = "0.1"))
+	float IdleNetPriority = 1.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category= "Net Policy", meta=(ClampMin = "0.1"))
+	float ActiveNetPriority = 3.0f;
+
+	/** Activity kept while the owner moves faster than MinMovingSpeed. */
+	UPROPERTY(EditDefaultsOnly, Category= "Net Policy", meta=(ClampMin = "0", ClampMax = "1"))
+	float MovingActivity = 0.5f;
+
+	UPROPERTY(EditDefaultsOnly, Category= "Net Policy", meta=(ClampMin = "0"))
+	float MinMovingSpeed = 10.0f;
+
+	/** Seconds to go from full activity to idle. */
+	UPROPERTY(EditDefaultsOnly, Category= "Net Policy", meta=(ClampMin = "0.1"))
+	float ActivityDecayTime = 2.0f;
+
+private:
+	void ApplyPolicy();
+
+	float Activity = 1.0f;
+};
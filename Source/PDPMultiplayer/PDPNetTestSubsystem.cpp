@@ -0,0 +1,293 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPNetTestSubsystem.h"
+
+#include "EngineUtils.h"
+#include "PDPMultiplayer.h"
+#include "PDPMultiplayerCharacter.h"
+#include "Camera/CameraComponent.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/CommandLine.h"
+
+static float GetPercentile(TArray<float>& Values, float Percentile)
+{
+	if (Values.Num() == 0)
+	{
+		return 0.0f;
+	}
+
+	Values.Sort();
+
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * Values.Num()) - 1, 0, Values.Num() - 1);
+	return Values[Index];
+}
+
+/** Reliable bunches received on every channel of Connection since it was opened. */
+static int64 GetInReliableBunches(const UNetConnection* Connection)
+{
+	// InReliable holds the sequence of the last reliable bunch received on each channel index. Sequences
+	// aren't reset when a channel index is reused, so their sum only grows with the reliable bunches.
+	int64 NumBunches = 0;
+	for (const int32 Sequence : Connection->InReliable)
+	{
+		NumBunches += Sequence;
+	}
+
+	return NumBunches;
+}
+
+void UPDPNetTestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const UWorld* World = GetWorld();
+	bEnabled = World && World->IsGameWorld() && FParse::Param(FCommandLine::Get(), TEXT("PDPNetTest"));
+
+	if (bEnabled)
+	{
+		PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UPDPNetTestSubsystem::OnWorldPostActorTick);
+	}
+}
+
+void UPDPNetTestSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+	Super::Deinitialize();
+}
+
+void UPDPNetTestSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || bFinished)
+	{
+		return;
+	}
+
+	// The client world only starts the scenario once the map is loaded and the connection is up.
+	const double Now = World->GetRealTimeSeconds();
+	if (StartTime <= 0.0)
+	{
+		if (Now >= WarmupSeconds && (World->GetNetMode() != NM_Client || World->GetFirstPlayerController()))
+		{
+			StartTime = Now;
+		}
+
+		return;
+	}
+
+	if (Now - StartTime >= ScenarioSeconds)
+	{
+		Finish(World);
+		return;
+	}
+
+	if (World->GetNetMode() == NM_Client)
+	{
+		TickClient(World);
+	}
+	else
+	{
+		TickServer(World);
+	}
+}
+
+void UPDPNetTestSubsystem::TickServer(UWorld* World)
+{
+	const UNetDriver* NetDriver = World->GetNetDriver();
+	if (!NetDriver)
+	{
+		return;
+	}
+
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		TrackConnection(Connection, World->GetRealTimeSeconds());
+	}
+}
+
+void UPDPNetTestSubsystem::TrackConnection(UNetConnection* Connection, double Now)
+{
+	if (!Connection || ConnectionStarts.Contains(Connection))
+	{
+		return;
+	}
+
+	FConnectionStart& ConnectionStart = ConnectionStarts.Add(Connection);
+	ConnectionStart.OutBytes = Connection->OutTotalBytes;
+	ConnectionStart.InReliableBunches = GetInReliableBunches(Connection);
+	ConnectionStart.Time = Now;
+}
+
+void UPDPNetTestSubsystem::TickClient(UWorld* World)
+{
+	APlayerController* PlayerController = World->GetFirstPlayerController();
+	APDPMultiplayerCharacter* Character = PlayerController ? Cast<APDPMultiplayerCharacter>(PlayerController->GetPawn()) : nullptr;
+
+	const double Now = World->GetRealTimeSeconds();
+
+	if (const UNetDriver* NetDriver = World->GetNetDriver())
+	{
+		TrackConnection(NetDriver->ServerConnection, Now);
+	}
+
+	// Effects that never replicated are misses, they must not show up as latency.
+	PendingAmmoShots.RemoveAll([this, Now](const FPendingShot& Shot) { return Now - Shot.Time > MaxPendingShotSeconds; });
+	PendingHitShots.RemoveAll([this, Now](const FPendingShot& Shot) { return Now - Shot.Time > MaxPendingShotSeconds; });
+
+	if (!Character || Character->IsDead())
+	{
+		SpawnTime = 0.0;
+		PendingAmmoShots.Reset();
+		return;
+	}
+
+	if (SpawnTime <= 0.0)
+	{
+		SpawnTime = Now;
+	}
+
+	// Ammo and the id of the last shot it includes replicate together.
+	while (PendingAmmoShots.Num() > 0 && static_cast<int16>(PendingAmmoShots[0].ShotId - Character->LastConfirmedShotId) <= 0)
+	{
+		AmmoLatencies.Add((Now - PendingAmmoShots[0].Time) * 1000.0);
+		PendingAmmoShots.RemoveAt(0, 1, false);
+	}
+
+	// Drops while no predicted hit is pending were done by another shooter.
+	const APDPMultiplayerCharacter* TargetCharacter = Target.Get();
+	if (TargetCharacter && TargetCharacter->GetHealth() < LastTargetHealth && PendingHitShots.Num() > 0)
+	{
+		HealthLatencies.Add((Now - PendingHitShots[0].Time) * 1000.0);
+		PendingHitShots.RemoveAt(0, 1, false);
+	}
+
+	if (TargetCharacter)
+	{
+		LastTargetHealth = TargetCharacter->GetHealth();
+	}
+
+	if (Now - SpawnTime < MoveSeconds)
+	{
+		Character->MoveForward(1.0f);
+		Character->MoveRight(FMath::Sin(Now));
+		return;
+	}
+
+	APDPMultiplayerCharacter* NewTarget = FindTarget(Character);
+	if (NewTarget != TargetCharacter)
+	{
+		Target = NewTarget;
+		LastTargetHealth = NewTarget ? NewTarget->GetHealth() : 0.0f;
+		PendingHitShots.Reset();
+	}
+
+	if (!NewTarget || Character->PredictedAmmo == 0)
+	{
+		return;
+	}
+
+	const FVector AimStart = Character->GetFollowCamera()->GetComponentLocation();
+	PlayerController->SetControlRotation((NewTarget->GetActorLocation() - AimStart).Rotation());
+
+	if (!Character->CanShoot())
+	{
+		return;
+	}
+
+	Character->Fire();
+
+	FPendingShot Shot;
+	Shot.ShotId = Character->LastPredictedShotId;
+	Shot.Time = Now;
+
+	PendingAmmoShots.Add(Shot);
+
+	// Misses never lower the health of the target and must not be paired with a drop caused by someone else.
+	if (Character->LineTrace() == NewTarget)
+	{
+		PendingHitShots.Add(Shot);
+	}
+}
+
+APDPMultiplayerCharacter* UPDPNetTestSubsystem::FindTarget(const APDPMultiplayerCharacter* Character) const
+{
+	APDPMultiplayerCharacter* NearestCharacter = nullptr;
+	float NearestDistanceSquared = TNumericLimits<float>::Max();
+
+	for (TActorIterator<APDPMultiplayerCharacter> It(GetWorld()); It; ++It)
+	{
+		APDPMultiplayerCharacter* OtherCharacter = *It;
+		if (OtherCharacter == Character || OtherCharacter->IsDead() || OtherCharacter->IsHidden())
+		{
+			continue;
+		}
+
+		const float DistanceSquared = FVector::DistSquared(Character->GetActorLocation(), OtherCharacter->GetActorLocation());
+		if (DistanceSquared < NearestDistanceSquared)
+		{
+			NearestDistanceSquared = DistanceSquared;
+			NearestCharacter = OtherCharacter;
+		}
+	}
+
+	return NearestCharacter;
+}
+
+void UPDPNetTestSubsystem::Finish(UWorld* World)
+{
+	bFinished = true;
+
+	const double Now = World->GetRealTimeSeconds();
+
+	// Connections closed before the end of the scenario took their counters with them.
+	float BytesPerSecond = 0.0f;
+	float ReliableBunchesPerSecond = 0.0f;
+	for (const TPair<TWeakObjectPtr<UNetConnection>, FConnectionStart>& ConnectionStart : ConnectionStarts)
+	{
+		const UNetConnection* Connection = ConnectionStart.Key.Get();
+		if (!Connection)
+		{
+			continue;
+		}
+
+		const double ConnectionDuration = FMath::Max(Now - ConnectionStart.Value.Time, 1.0);
+		BytesPerSecond = FMath::Max(BytesPerSecond, static_cast<float>((Connection->OutTotalBytes - ConnectionStart.Value.OutBytes) / ConnectionDuration));
+		ReliableBunchesPerSecond = FMath::Max(ReliableBunchesPerSecond, static_cast<float>((GetInReliableBunches(Connection) - ConnectionStart.Value.InReliableBunches) / ConnectionDuration));
+	}
+
+	bool bPassed = CheckBudget(TEXT("Reliable bunches per second per connection"), ReliableBunchesPerSecond, MaxReliableBunchesPerSecond);
+
+	if (World->GetNetMode() == NM_Client)
+	{
+		bPassed &= CheckBudget(TEXT("Health latency p95 (ms)"), GetPercentile(HealthLatencies, 0.95f), MaxHealthLatencyMs);
+		bPassed &= CheckBudget(TEXT("Ammo latency p95 (ms)"), GetPercentile(AmmoLatencies, 0.95f), MaxAmmoLatencyMs);
+	}
+	else
+	{
+		bPassed &= CheckBudget(TEXT("Bytes per second per connection"), BytesPerSecond, MaxBytesPerSecondPerConnection);
+	}
+
+	UE_LOG(LogPDPMultiplayer, Display, TEXT("NetTest: %s"), bPassed ? TEXT("PASSED") : TEXT("FAILED"));
+
+	FPlatformMisc::RequestExitWithStatus(false, bPassed ? 0 : 1);
+}
+
+bool UPDPNetTestSubsystem::CheckBudget(const TCHAR* Name, float Value, float Budget) const
+{
+	const bool bWithinBudget = Value <= Budget;
+	if (bWithinBudget)
+	{
+		UE_LOG(LogPDPMultiplayer, Display, TEXT("NetTest: %s %.2f, budget %.2f"), Name, Value, Budget);
+	}
+	else
+	{
+		UE_LOG(LogPDPMultiplayer, Error, TEXT("NetTest: %s %.2f is over budget %.2f"), Name, Value, Budget);
+	}
+
+	return bWithinBudget;
+}
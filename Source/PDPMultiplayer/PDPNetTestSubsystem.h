@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PDPNetTestSubsystem.generated.h"
+
+class APDPMultiplayerCharacter;
+class UNetConnection;
+
+/**
+ * Network regression gate, enabled with -PDPNetTest on the server and on every client of a local match:
+ *	Server:		PDPMultiplayer <Map>?listen -server -nullrhi -PDPNetTest
+ *	Clients:	PDPMultiplayer 127.0.0.1 -game -nullrhi -nosound -PDPNetTest
+ *
+ * Each client plays a scripted scenario with its character: it moves, then fires at the nearest enemy until
+ * its ammo runs out, dies and is respawned by the game mode, and starts over until the scenario ends.
+ * The server measures the bytes sent to every connection, clients the shot to replicated Ammo and Health
+ * latencies, and both the reliable bunches they receive on each connection, which include every reliable
+ * RPC. Every metric is compared to its budget below and the process exits with a non-zero code when one
+ * of them is over budget.
+ */
+UCLASS(config=Game)
+class PDPMULTIPLAYER_API UPDPNetTestSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Seconds between the start of the match and the start of the measurements. */
+	UPROPERTY(config)
+	float WarmupSeconds = 5.0f;
+
+	UPROPERTY(config)
+	float ScenarioSeconds = 60.0f;
+
+	/** Seconds a client moves around after each spawn before it starts firing. */
+	UPROPERTY(config)
+	float MoveSeconds = 3.0f;
+
+	/** Shots whose effect hasn't replicated after this many seconds are counted as misses. */
+	UPROPERTY(config)
+	float MaxPendingShotSeconds = 1.0f;
+
+	// Budgets:
+	/** Bytes per second the server may send to a single connection. */
+	UPROPERTY(config)
+	float MaxBytesPerSecondPerConnection = 6000.0f;
+
+	/** Reliable bunches per second a client may receive, or the server may receive from one connection. */
+	UPROPERTY(config)
+	float MaxReliableBunchesPerSecond = 12.0f;
+
+	/** 95th percentile of the time between a shot the client predicted as a hit and the replicated health drop of its target. */
+	UPROPERTY(config)
+	float MaxHealthLatencyMs = 250.0f;
+
+	/** 95th percentile of the time between a shot and the replicated ammo confirming it. */
+	UPROPERTY(config)
+	float MaxAmmoLatencyMs = 250.0f;
+
+private:
+	struct FPendingShot
+	{
+		uint16 ShotId = 0;
+		double Time = 0.0;
+	};
+
+	/** Counters of a connection when it was first seen. */
+	struct FConnectionStart
+	{
+		int64 OutBytes = 0;
+		int64 InReliableBunches = 0;
+		double Time = 0.0;
+	};
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void TickServer(UWorld* World);
+	void TickClient(UWorld* World);
+
+	void TrackConnection(UNetConnection* Connection, double Now);
+
+	APDPMultiplayerCharacter* FindTarget(const APDPMultiplayerCharacter* Character) const;
+
+	void Finish(UWorld* World);
+	bool CheckBudget(const TCHAR* Name, float Value, float Budget) const;
+
+	bool bEnabled = false;
+	bool bFinished = false;
+
+	double StartTime = 0.0;
+	double SpawnTime = 0.0;
+
+	/** Server: every client connection, client: the connection to the server. */
+	TMap<TWeakObjectPtr<UNetConnection>, FConnectionStart> ConnectionStarts;
+
+	/** Client: shots waiting for the replicated ammo, and the predicted hits waiting for the health drop of the target. */
+	TArray<FPendingShot> PendingAmmoShots;
+	TArray<FPendingShot> PendingHitShots;
+
+	TWeakObjectPtr<APDPMultiplayerCharacter> Target;
+	float LastTargetHealth = 0.0f;
+
+	TArray<float> HealthLatencies;
+	TArray<float> AmmoLatencies;
+
+	FDelegateHandle PostActorTickHandle;
+};
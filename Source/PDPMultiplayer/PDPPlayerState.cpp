@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPPlayerState.h"
+
+#include "PDPGameState.h"
+#include "Engine/World.h"
+
+void APDPPlayerState::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (HasAuthority())
+	{
+		UpdateScoreboardEntry();
+	}
+}
+
+void APDPPlayerState::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UWorld* World = GetWorld();
+	APDPGameState* GameState = World ? World->GetGameState<APDPGameState>() : nullptr;
+	if (GameState && HasAuthority())
+	{
+		GameState->GetScoreboard().RemoveEntry(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void APDPPlayerState::AddKill(float ScoreAmount)
+{
+	++Kills;
+	SetScore(GetScore() + ScoreAmount);
+
+	UpdateScoreboardEntry();
+}
+
+void APDPPlayerState::AddDeath()
+{
+	++Deaths;
+
+	UpdateScoreboardEntry();
+}
+
+void APDPPlayerState::CopyProperties(APlayerState* PlayerState)
+{
+	Super::CopyProperties(PlayerState);
+
+	if (APDPPlayerState* NewPlayerState = Cast<APDPPlayerState>(PlayerState))
+	{
+		NewPlayerState->Kills = Kills;
+		NewPlayerState->Deaths = Deaths;
+
+		if (NewPlayerState->HasAuthority())
+		{
+			NewPlayerState->UpdateScoreboardEntry();
+		}
+	}
+}
+
+void APDPPlayerState::OverrideWith(APlayerState* PlayerState)
+{
+	Super::OverrideWith(PlayerState);
+
+	if (const APDPPlayerState* OldPlayerState = Cast<APDPPlayerState>(PlayerState))
+	{
+		Kills = OldPlayerState->Kills;
+		Deaths = OldPlayerState->Deaths;
+
+		if (HasAuthority())
+		{
+			UpdateScoreboardEntry();
+		}
+	}
+}
+
+void APDPPlayerState::UpdateScoreboardEntry()
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	APDPGameState* GameState = World->GetGameState<APDPGameState>();
+	if (!GameState)
+	{
+		return;
+	}
+
+	GameState->GetScoreboard().SetEntry(this, Kills, Deaths, FMath::RoundToInt(GetScore()));
+}
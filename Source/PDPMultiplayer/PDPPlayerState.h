@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/PlayerState.h"
+#include "PDPPlayerState.generated.h"
+
+/**
+ * Kills and deaths of a player. They are counted on the server and only replicate through the
+ * scoreboard row of the player, kept by the game state.
+ */
+UCLASS()
+class PDPMULTIPLAYER_API APDPPlayerState : public APlayerState
+{
+	GENERATED_BODY()
+
+public:
+	/** Server only. */
+	void AddKill(float ScoreAmount);
+	void AddDeath();
+
+	FORCEINLINE int32 GetKills() const { return Kills; }
+	FORCEINLINE int32 GetDeaths() const { return Deaths; }
+
+	/** Carries the kills and deaths over seamless travel and to an inactive player state on reconnect. */
+	virtual void CopyProperties(APlayerState* PlayerState) override;
+	virtual void OverrideWith(APlayerState* PlayerState) override;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	void UpdateScoreboardEntry();
+
+	int32 Kills = 0;
+	int32 Deaths = 0;
+};
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPPreloadSubsystem.h"
+
+#include "PDPMultiplayer.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "UObject/UObjectGlobals.h"
+
+void UPDPPreloadSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PreLoadMapHandle = FCoreUObjectDelegates::PreLoadMap.AddUObject(this, &UPDPPreloadSubsystem::OnPreLoadMap);
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UPDPPreloadSubsystem::OnPostLoadMapWithWorld);
+}
+
+void UPDPPreloadSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::PreLoadMap.Remove(PreLoadMapHandle);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+
+	if (PreloadHandle.IsValid())
+	{
+		PreloadHandle->CancelHandle();
+		PreloadHandle.Reset();
+	}
+
+	Super::Deinitialize();
+}
+
+void UPDPPreloadSubsystem::StartPreload()
+{
+	if (PreloadHandle.IsValid())
+	{
+		return;
+	}
+
+	TArray<FSoftObjectPath> AssetsToLoad = PreloadAssets;
+	if (!MatchMap.IsNull())
+	{
+		AssetsToLoad.Add(MatchMap);
+	}
+
+	if (AssetsToLoad.Num() == 0)
+	{
+		return;
+	}
+
+	PreloadStartTime = FPlatformTime::Seconds();
+
+	// The map is loaded as an asset, the engine travels into the world in memory without loading it from disk again.
+	PreloadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetsToLoad, FStreamableDelegate::CreateUObject(this, &UPDPPreloadSubsystem::OnPreloadComplete));
+}
+
+bool UPDPPreloadSubsystem::IsPreloadComplete() const
+{
+	return !PreloadHandle.IsValid() || PreloadHandle->HasLoadCompleted();
+}
+
+void UPDPPreloadSubsystem::OnPreloadComplete()
+{
+	UE_LOG(LogPDPMultiplayer, Log, TEXT("Preload: %s and %d assets loaded in %.2f s"), *MatchMap.GetLongPackageName(), PreloadAssets.Num(), FPlatformTime::Seconds() - PreloadStartTime);
+}
+
+void UPDPPreloadSubsystem::OnPreLoadMap(const FString& MapName)
+{
+	LoadMapStartTime = FPlatformTime::Seconds();
+}
+
+void UPDPPreloadSubsystem::OnPostLoadMapWithWorld(UWorld* World)
+{
+	// The start menu map itself, or a map opened without preloading.
+	if (PreloadStartTime <= 0.0 || PreloadStartTime > LoadMapStartTime)
+	{
+		return;
+	}
+
+	UE_LOG(LogPDPMultiplayer, Log, TEXT("Preload: %s opened in %.2f s, preload %s"), World ? *World->GetMapName() : TEXT("map"), FPlatformTime::Seconds() - LoadMapStartTime,
+		IsPreloadComplete() ? TEXT("complete") : TEXT("incomplete"));
+
+	PreloadStartTime = 0.0;
+	bWaitingForPawn = true;
+
+	// The new world holds what it uses, holding the map any longer would keep it alive after the match.
+	if (PreloadHandle.IsValid())
+	{
+		PreloadHandle->ReleaseHandle();
+		PreloadHandle.Reset();
+	}
+}
+
+void UPDPPreloadSubsystem::NotifyPawnClientRestart()
+{
+	if (!bWaitingForPawn)
+	{
+		return;
+	}
+
+	bWaitingForPawn = false;
+
+	UE_LOG(LogPDPMultiplayer, Log, TEXT("Preload: controllable character %.2f s after the map started loading"), FPlatformTime::Seconds() - LoadMapStartTime);
+}
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "UObject/SoftObjectPath.h"
+#include "PDPPreloadSubsystem.generated.h"
+
+struct FStreamableHandle;
+
+/**
+ * Loads the match map and the assets it needs in the background while the start menu is up, so hosting
+ * or joining a match finds them in memory instead of loading them when the map opens. The map world and
+ * the assets are held by a single streamable handle until the next map is loaded, the new world
+ * references them from there. Logs the time to open the map and to get a controllable character.
+ */
+UCLASS(config=Game)
+class PDPMULTIPLAYER_API UPDPPreloadSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Starts loading MatchMap and PreloadAssets, if they aren't loaded or loading already. */
+	void StartPreload();
+
+	bool IsPreloadComplete() const;
+
+	/** Called when the local player gets a character, the first one after a preloaded map opens is timed. */
+	void NotifyPawnClientRestart();
+
+	UPROPERTY(config)
+	FSoftObjectPath MatchMap;
+
+	/** Assets the match map only reaches through soft references, or that are spawned at run time. */
+	UPROPERTY(config)
+	TArray<FSoftObjectPath> PreloadAssets;
+
+private:
+	void OnPreloadComplete();
+
+	void OnPreLoadMap(const FString& MapName);
+	void OnPostLoadMapWithWorld(UWorld* World);
+
+	/** Holds the map world, a package alone doesn't keep its world from being garbage collected. */
+	TSharedPtr<FStreamableHandle> PreloadHandle;
+
+	double PreloadStartTime = 0.0;
+	double LoadMapStartTime = 0.0;
+
+	/** Whether a preloaded map opened and the local player has no character yet. */
+	bool bWaitingForPawn = false;
+
+	FDelegateHandle PreLoadMapHandle;
+	FDelegateHandle PostLoadMapHandle;
+};
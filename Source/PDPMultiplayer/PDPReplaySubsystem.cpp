@@ -0,0 +1,439 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPReplaySubsystem.h"
+
+#include "PDPMultiplayer.h"
+#include "PDPMultiplayerCharacter.h"
+#include "Async/Async.h"
+#include "Camera/CameraActor.h"
+#include "Components/LineBatchComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static int32 GReplayEnable = 1;
+static FAutoConsoleVariableRef CVarReplayEnable(
+	TEXT("PDP.Replay.Enable"),
+	GReplayEnable,
+	TEXT("Record the last seconds of the match on the server, for the kill-cam and PDP.Replay.Dump."),
+	ECVF_Default);
+
+static float GReplayBufferSeconds = 15.0f;
+static FAutoConsoleVariableRef CVarReplayBufferSeconds(
+	TEXT("PDP.Replay.BufferSeconds"),
+	GReplayBufferSeconds,
+	TEXT("Seconds of the match kept by the replay buffer. Changing it clears the buffer."),
+	ECVF_Default);
+
+static float GReplaySampleRate = 20.0f;
+static FAutoConsoleVariableRef CVarReplaySampleRate(
+	TEXT("PDP.Replay.SampleRate"),
+	GReplaySampleRate,
+	TEXT("Character poses recorded per second. Changing it clears the buffer."),
+	ECVF_Default);
+
+static float GReplayKillCamSeconds = 2.0f;
+static FAutoConsoleVariableRef CVarReplayKillCamSeconds(
+	TEXT("PDP.Replay.KillCamSeconds"),
+	GReplayKillCamSeconds,
+	TEXT("Seconds before a death sent to the victim as its kill-cam, 0 disables the kill-cam. Best kept under the respawn delay."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs ReplayDumpCommand(
+	TEXT("PDP.Replay.Dump"),
+	TEXT("Writes the replay buffer of the server to Saved/Replays. Usage: PDP.Replay.Dump [FileName]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const UPDPReplaySubsystem* Replay = World ? World->GetSubsystem<UPDPReplaySubsystem>() : nullptr;
+		if (!Replay || !Replay->IsRecording())
+		{
+			UE_LOG(LogPDPMultiplayer, Warning, TEXT("PDP.Replay.Dump: no replay is recorded in this world, run it on the server."));
+			return;
+		}
+
+		const FString FileName = Args.Num() > 0 ? Args[0] : FString::Printf(TEXT("PDPReplay-%s"), *FDateTime::Now().ToString());
+		Replay->DumpToFile(FileName);
+	}),
+	ECVF_Cheat);
+
+void UPDPReplaySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UPDPReplaySubsystem::OnWorldPostActorTick);
+}
+
+void UPDPReplaySubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+	StopKillCam();
+
+	if (KillCamTracers)
+	{
+		KillCamTracers->DestroyComponent();
+		KillCamTracers = nullptr;
+	}
+
+	Frames.Empty();
+	Shots.Empty();
+	Deaths.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UPDPReplaySubsystem::IsRecording() const
+{
+	const UWorld* World = GetWorld();
+	return GReplayEnable != 0 && World && World->IsGameWorld() && World->GetNetMode() != NM_Client;
+}
+
+void UPDPReplaySubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld())
+	{
+		return;
+	}
+
+	if (KillCamCamera.IsValid())
+	{
+		UpdateKillCam(World);
+	}
+
+	if (!IsRecording() || World->GetTimeSeconds() < NextSampleTime)
+	{
+		return;
+	}
+
+	NextSampleTime = World->GetTimeSeconds() + 1.0f / FMath::Max(GReplaySampleRate, 1.0f);
+	RecordFrame(World);
+}
+
+void UPDPReplaySubsystem::RecordFrame(UWorld* World)
+{
+	PDP_SCOPE_CYCLE_COUNTER(STAT_PDP_RecordReplay, RecordReplay);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	const int32 MaxFrames = FMath::Max(FMath::CeilToInt(GReplayBufferSeconds * FMath::Max(GReplaySampleRate, 1.0f)), 1);
+	if (MaxFrames != FrameCapacity)
+	{
+		Frames.Reset();
+		Frames.Reserve(MaxFrames);
+		FrameCapacity = MaxFrames;
+		NextFrameIndex = 0;
+	}
+
+	// The ring only grows until it is full, then the oldest frame and its samples are reused.
+	if (Frames.Num() < FrameCapacity)
+	{
+		NextFrameIndex = Frames.AddDefaulted();
+	}
+
+	FFrame& Frame = Frames[NextFrameIndex];
+	Frame.Time = World->GetTimeSeconds();
+	Frame.Samples.Reset();
+
+	if (const AGameStateBase* GameState = World->GetGameState())
+	{
+		for (const APlayerState* PlayerState : GameState->PlayerArray)
+		{
+			const APDPMultiplayerCharacter* Character = PlayerState ? PlayerState->GetPawn<APDPMultiplayerCharacter>() : nullptr;
+			if (!Character)
+			{
+				continue;
+			}
+
+			const FRotator Aim = Character->GetBaseAimRotation();
+
+			FSample& Sample = Frame.Samples.AddDefaulted_GetRef();
+			Sample.PlayerId = PlayerState->GetPlayerId();
+			Sample.Location = Character->GetActorLocation();
+			Sample.Yaw = FRotator::CompressAxisToShort(Aim.Yaw);
+			Sample.Pitch = FRotator::CompressAxisToShort(Aim.Pitch);
+			Sample.Health = static_cast<uint16>(FMath::Clamp(FMath::CeilToInt(Character->GetHealth()), 0, MAX_uint16));
+			Sample.bDead = Character->IsDead();
+		}
+	}
+
+	NextFrameIndex = (NextFrameIndex + 1) % FrameCapacity;
+
+	TrimEvents(Frame.Time);
+
+	TotalRecordSeconds += FPlatformTime::Seconds() - StartTime;
+	++NumRecordedFrames;
+}
+
+void UPDPReplaySubsystem::TrimEvents(float Now)
+{
+	const float OldestTime = Now - GReplayBufferSeconds;
+
+	const int32 NumExpiredShots = Shots.IndexOfByPredicate([OldestTime](const FShot& Shot) { return Shot.Time >= OldestTime; });
+	Shots.RemoveAt(0, NumExpiredShots == INDEX_NONE ? Shots.Num() : NumExpiredShots, false);
+
+	const int32 NumExpiredDeaths = Deaths.IndexOfByPredicate([OldestTime](const FDeath& Death) { return Death.Time >= OldestTime; });
+	Deaths.RemoveAt(0, NumExpiredDeaths == INDEX_NONE ? Deaths.Num() : NumExpiredDeaths, false);
+}
+
+template<typename VisitorType>
+void UPDPReplaySubsystem::ForEachFrame(VisitorType Visitor) const
+{
+	// Until the ring is full the frames are in order from the first one.
+	const int32 FirstIndex = Frames.Num() == FrameCapacity ? NextFrameIndex : 0;
+	for (int32 Offset = 0; Offset < Frames.Num(); ++Offset)
+	{
+		Visitor(Frames[(FirstIndex + Offset) % Frames.Num()]);
+	}
+}
+
+void UPDPReplaySubsystem::RecordShot(const APDPMultiplayerCharacter* Shooter, const FVector& Start, const FVector& End, const AActor* HitActor)
+{
+	if (!Shooter || !IsRecording())
+	{
+		return;
+	}
+
+	FShot& Shot = Shots.AddDefaulted_GetRef();
+	Shot.Time = GetWorld()->GetTimeSeconds();
+	Shot.ShooterId = APDPMultiplayerCharacter::GetPlayerId(Shooter);
+	Shot.Start = Start;
+	Shot.End = End;
+	Shot.HitPlayerId = APDPMultiplayerCharacter::GetPlayerId(HitActor);
+}
+
+bool UPDPReplaySubsystem::RecordDeath(const APDPMultiplayerCharacter* Victim, const AController* Killer, FPDPKillCam& OutKillCam)
+{
+	if (!Victim || !IsRecording())
+	{
+		return false;
+	}
+
+	const APawn* KillerPawn = Killer ? Killer->GetPawn() : nullptr;
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	FDeath& Death = Deaths.AddDefaulted_GetRef();
+	Death.Time = Now;
+	Death.VictimId = APDPMultiplayerCharacter::GetPlayerId(Victim);
+	Death.KillerId = APDPMultiplayerCharacter::GetPlayerId(KillerPawn);
+
+	if (Death.KillerId == INDEX_NONE || KillerPawn == Victim || GReplayKillCamSeconds <= 0.0f)
+	{
+		return false;
+	}
+
+	const int32 KillerId = Death.KillerId;
+	const float StartTime = Now - GReplayKillCamSeconds;
+
+	OutKillCam.Frames.Reset();
+	OutKillCam.Shots.Reset();
+
+	ForEachFrame([&OutKillCam, KillerId, StartTime](const FFrame& Frame)
+	{
+		if (Frame.Time < StartTime)
+		{
+			return;
+		}
+
+		const FSample* Sample = Frame.Samples.FindByPredicate([KillerId](const FSample& Candidate) { return Candidate.PlayerId == KillerId; });
+		if (!Sample)
+		{
+			return;
+		}
+
+		FPDPKillCamFrame& KillCamFrame = OutKillCam.Frames.AddDefaulted_GetRef();
+		KillCamFrame.Time = Frame.Time;
+		KillCamFrame.Location = Sample->Location;
+		KillCamFrame.Yaw = Sample->Yaw;
+		KillCamFrame.Pitch = Sample->Pitch;
+	});
+
+	for (const FShot& Shot : Shots)
+	{
+		if (Shot.Time >= StartTime && Shot.ShooterId == KillerId)
+		{
+			FPDPKillCamShot& KillCamShot = OutKillCam.Shots.AddDefaulted_GetRef();
+			KillCamShot.Time = Shot.Time;
+			KillCamShot.Start = Shot.Start;
+			KillCamShot.End = Shot.End;
+			KillCamShot.bHit = Shot.HitPlayerId != INDEX_NONE;
+		}
+	}
+
+	// Two frames are needed to move the camera.
+	return OutKillCam.Frames.Num() > 1;
+}
+
+int64 UPDPReplaySubsystem::GetAllocatedSize() const
+{
+	int64 Size = Frames.GetAllocatedSize() + Shots.GetAllocatedSize() + Deaths.GetAllocatedSize();
+	for (const FFrame& Frame : Frames)
+	{
+		Size += Frame.Samples.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+FString UPDPReplaySubsystem::DumpToFile(const FString& FileName) const
+{
+	FString Rows;
+
+	Rows += TEXT("Frame,Time,PlayerId,X,Y,Z,Yaw,Pitch,Health,Dead\n");
+	ForEachFrame([&Rows](const FFrame& Frame)
+	{
+		for (const FSample& Sample : Frame.Samples)
+		{
+			Rows += FString::Printf(TEXT("Frame,%.3f,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%u,%d\n"),
+				Frame.Time, Sample.PlayerId, Sample.Location.X, Sample.Location.Y, Sample.Location.Z,
+				FRotator::DecompressAxisFromShort(Sample.Yaw), FRotator::DecompressAxisFromShort(Sample.Pitch), Sample.Health, Sample.bDead ? 1 : 0);
+		}
+	});
+
+	Rows += TEXT("Shot,Time,ShooterId,StartX,StartY,StartZ,EndX,EndY,EndZ,HitPlayerId\n");
+	for (const FShot& Shot : Shots)
+	{
+		Rows += FString::Printf(TEXT("Shot,%.3f,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%d\n"),
+			Shot.Time, Shot.ShooterId, Shot.Start.X, Shot.Start.Y, Shot.Start.Z, Shot.End.X, Shot.End.Y, Shot.End.Z, Shot.HitPlayerId);
+	}
+
+	Rows += TEXT("Death,Time,VictimId,KillerId\n");
+	for (const FDeath& Death : Deaths)
+	{
+		Rows += FString::Printf(TEXT("Death,%.3f,%d,%d\n"), Death.Time, Death.VictimId, Death.KillerId);
+	}
+
+	const FString FilePath = FPaths::ProjectSavedDir() / TEXT("Replays") / (FileName + TEXT(".csv"));
+
+	UE_LOG(LogPDPMultiplayer, Display, TEXT("Replay dumped to %s: %d frames, %d shots, %d deaths, %lld KB in memory, %.3f ms per recorded frame"),
+		*FilePath, Frames.Num(), Shots.Num(), Deaths.Num(), GetAllocatedSize() / 1024,
+		NumRecordedFrames > 0 ? TotalRecordSeconds * 1000.0 / NumRecordedFrames : 0.0);
+
+	Async(EAsyncExecution::ThreadPool, [Rows = MoveTemp(Rows), FilePath]()
+	{
+		FFileHelper::SaveStringToFile(Rows, *FilePath, FFileHelper::EEncodingOptions::ForceAnsi, &IFileManager::Get());
+	});
+
+	return FilePath;
+}
+
+void UPDPReplaySubsystem::PlayKillCam(APlayerController* PlayerController, const FPDPKillCam& InKillCam)
+{
+#if !UE_SERVER
+	UWorld* World = GetWorld();
+	if (!World || !PlayerController || InKillCam.Frames.Num() < 2)
+	{
+		return;
+	}
+
+	StopKillCam();
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.ObjectFlags |= RF_Transient;
+
+	ACameraActor* Camera = World->SpawnActor<ACameraActor>(SpawnParameters);
+	if (!Camera)
+	{
+		return;
+	}
+
+	if (!KillCamTracers)
+	{
+		KillCamTracers = NewObject<ULineBatchComponent>(this);
+		KillCamTracers->bCalculateAccurateBounds = false;
+		KillCamTracers->RegisterComponentWithWorld(World);
+	}
+
+	KillCam = InKillCam;
+	KillCamPlayerController = PlayerController;
+	KillCamCamera = Camera;
+	KillCamStartTime = World->GetTimeSeconds();
+
+	PlayerController->SetViewTarget(Camera);
+	UpdateKillCam(World);
+#endif
+}
+
+void UPDPReplaySubsystem::UpdateKillCam(UWorld* World)
+{
+#if !UE_SERVER
+	const APlayerController* PlayerController = KillCamPlayerController.Get();
+	ACameraActor* Camera = KillCamCamera.Get();
+
+	// The respawn makes the new character the view target, which ends the kill-cam.
+	if (!PlayerController || !Camera || PlayerController->GetViewTarget() != Camera)
+	{
+		StopKillCam();
+		return;
+	}
+
+	const TArray<FPDPKillCamFrame>& KillCamFrames = KillCam.Frames;
+	const float Time = KillCamFrames[0].Time + static_cast<float>(World->GetTimeSeconds() - KillCamStartTime);
+	if (Time >= KillCamFrames.Last().Time)
+	{
+		StopKillCam();
+		return;
+	}
+
+	int32 FrameIndex = 0;
+	while (FrameIndex < KillCamFrames.Num() - 2 && KillCamFrames[FrameIndex + 1].Time <= Time)
+	{
+		++FrameIndex;
+	}
+
+	const FPDPKillCamFrame& From = KillCamFrames[FrameIndex];
+	const FPDPKillCamFrame& To = KillCamFrames[FrameIndex + 1];
+	const float Alpha = FMath::Clamp((Time - From.Time) / FMath::Max(To.Time - From.Time, KINDA_SMALL_NUMBER), 0.0f, 1.0f);
+
+	const FQuat FromAim = FRotator(FRotator::DecompressAxisFromShort(From.Pitch), FRotator::DecompressAxisFromShort(From.Yaw), 0.0f).Quaternion();
+	const FQuat ToAim = FRotator(FRotator::DecompressAxisFromShort(To.Pitch), FRotator::DecompressAxisFromShort(To.Yaw), 0.0f).Quaternion();
+	const FQuat Aim = FQuat::Slerp(FromAim, ToAim, Alpha);
+	const FVector Location = FMath::Lerp<FVector>(From.Location, To.Location, Alpha);
+
+	// Over the shoulder of the killer, looking where it aimed.
+	Camera->SetActorLocationAndRotation(Location - Aim.GetForwardVector() * 300.0f + FVector(0.0f, 0.0f, 80.0f), Aim);
+
+	// Redrawn every frame, the lines live until the next flush.
+	KillCamTracers->Flush();
+	for (const FPDPKillCamShot& Shot : KillCam.Shots)
+	{
+		if (Shot.Time <= Time && Time - Shot.Time < 0.25f)
+		{
+			KillCamTracers->DrawLine(Shot.Start, Shot.End, Shot.bHit ? FLinearColor::Red : FLinearColor::Yellow, SDPG_World, 2.0f, MAX_flt);
+		}
+	}
+#endif
+}
+
+void UPDPReplaySubsystem::StopKillCam()
+{
+	ACameraActor* Camera = KillCamCamera.Get();
+	APlayerController* PlayerController = KillCamPlayerController.Get();
+
+	// Back to the dead character until the respawn.
+	if (PlayerController && Camera && PlayerController->GetViewTarget() == Camera)
+	{
+		PlayerController->SetViewTarget(PlayerController->GetPawn());
+	}
+
+	if (Camera)
+	{
+		Camera->Destroy();
+	}
+
+	if (KillCamTracers)
+	{
+		KillCamTracers->Flush();
+	}
+
+	KillCamCamera.Reset();
+	KillCamPlayerController.Reset();
+	KillCam.Frames.Reset();
+	KillCam.Shots.Reset();
+}
@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PDPReplaySubsystem.generated.h"
+
+class ACameraActor;
+class AController;
+class ULineBatchComponent;
+class APDPMultiplayerCharacter;
+class APlayerController;
+
+/** Pose of the killer at a server time, as sent to its victim. */
+USTRUCT()
+struct FPDPKillCamFrame
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	float Time = 0.0f;
+
+	UPROPERTY()
+	FVector_NetQuantize Location = FVector::ZeroVector;
+
+	/** Aim, compressed with FRotator::CompressAxisToShort. */
+	UPROPERTY()
+	uint16 Yaw = 0;
+
+	UPROPERTY()
+	uint16 Pitch = 0;
+};
+
+USTRUCT()
+struct FPDPKillCamShot
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	float Time = 0.0f;
+
+	UPROPERTY()
+	FVector_NetQuantize Start = FVector::ZeroVector;
+
+	UPROPERTY()
+	FVector_NetQuantize End = FVector::ZeroVector;
+
+	UPROPERTY()
+	bool bHit = false;
+};
+
+/** The last seconds of the killer, played back by the victim while it waits to respawn. */
+USTRUCT()
+struct FPDPKillCam
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FPDPKillCamFrame> Frames;
+
+	UPROPERTY()
+	TArray<FPDPKillCamShot> Shots;
+};
+
+/**
+ * Match recorder. The server samples the pose, aim and health of every character PDP.Replay.SampleRate times
+ * a second into a ring of frames covering PDP.Replay.BufferSeconds, along with the confirmed shots and the
+ * deaths. The ring is allocated once and reused, so its memory is bounded by the buffer length and the number
+ * of players. A victim is sent the last PDP.Replay.KillCamSeconds of its killer and plays them back as a
+ * kill-cam; PDP.Replay.Dump writes the whole buffer to a file in the saved directory.
+ *
+ * Recording time shows as Record Replay in "stat PDP".
+ */
+UCLASS()
+class PDPMULTIPLAYER_API UPDPReplaySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	bool IsRecording() const;
+
+	/** @param HitActor	Character hit by the shot, nullptr for a miss */
+	void RecordShot(const APDPMultiplayerCharacter* Shooter, const FVector& Start, const FVector& End, const AActor* HitActor);
+
+	/** Records the death of Victim and fills the kill-cam of its killer. Returns false when there is nothing to show. */
+	bool RecordDeath(const APDPMultiplayerCharacter* Victim, const AController* Killer, FPDPKillCam& OutKillCam);
+
+	/** Writes the buffer to Saved/Replays/FileName.csv on a worker thread. Returns the path of the file. */
+	FString DumpToFile(const FString& FileName) const;
+
+	/** Shows InKillCam from the view of PlayerController until it ends or the player gets a new pawn. */
+	void PlayKillCam(APlayerController* PlayerController, const FPDPKillCam& InKillCam);
+
+private:
+	struct FSample
+	{
+		int32 PlayerId = INDEX_NONE;
+		FVector Location = FVector::ZeroVector;
+		uint16 Yaw = 0;
+		uint16 Pitch = 0;
+		uint16 Health = 0;
+		bool bDead = false;
+	};
+
+	struct FFrame
+	{
+		float Time = 0.0f;
+		TArray<FSample> Samples;
+	};
+
+	struct FShot
+	{
+		float Time = 0.0f;
+		int32 ShooterId = INDEX_NONE;
+		FVector Start = FVector::ZeroVector;
+		FVector End = FVector::ZeroVector;
+		int32 HitPlayerId = INDEX_NONE;
+	};
+
+	struct FDeath
+	{
+		float Time = 0.0f;
+		int32 VictimId = INDEX_NONE;
+		int32 KillerId = INDEX_NONE;
+	};
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void RecordFrame(UWorld* World);
+
+	/** Drops the shots and deaths older than the buffer. */
+	void TrimEvents(float Now);
+
+	/** Calls Visitor on the recorded frames, oldest first. */
+	template<typename VisitorType>
+	void ForEachFrame(VisitorType Visitor) const;
+
+	int64 GetAllocatedSize() const;
+
+	void UpdateKillCam(UWorld* World);
+	void StopKillCam();
+
+	TArray<FFrame> Frames;
+	int32 FrameCapacity = 0;
+	int32 NextFrameIndex = 0;
+	float NextSampleTime = 0.0f;
+
+	TArray<FShot> Shots;
+	TArray<FDeath> Deaths;
+
+	/** Recording cost since the subsystem was created, logged by the dump. */
+	double TotalRecordSeconds = 0.0;
+	int32 NumRecordedFrames = 0;
+
+	// Kill-cam playback, on the victim:
+	FPDPKillCam KillCam;
+	TWeakObjectPtr<APlayerController> KillCamPlayerController;
+	TWeakObjectPtr<ACameraActor> KillCamCamera;
+	double KillCamStartTime = 0.0;
+
+	/** Draws the tracers of the kill-cam shots, created with the first kill-cam and reused by the next ones. */
+	UPROPERTY(Transient)
+	ULineBatchComponent* KillCamTracers = nullptr;
+
+	FDelegateHandle PostActorTickHandle;
+};
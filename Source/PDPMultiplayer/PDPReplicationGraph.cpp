@@ -0,0 +1,278 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPReplicationGraph.h"
+
+#include "PDPNetAccountingSubsystem.h"
+#include "Engine/ActorChannel.h"
+#include "Engine/Brush.h"
+#include "Engine/NetConnection.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_CYCLE_STAT(TEXT("Server Replicate Actors"), STAT_PDPRepGraph_ServerReplicateActors, STATGROUP_PDPReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Connections"), STAT_PDPRepGraph_Connections, STATGROUP_PDPReplicationGraph);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Gather And Replicate Average Per Connection (ms)"), STAT_PDPRepGraph_AverageCostPerConnection, STATGROUP_PDPReplicationGraph);
+
+void UPDPReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	// Actors explicitly routed to this connection.
+	if (ReplicationActorList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+	}
+
+	ViewerActors.Reset();
+
+	for (const FNetViewer& Viewer : Params.Viewers)
+	{
+		ViewerActors.ConditionalAdd(Viewer.InViewer);
+		ViewerActors.ConditionalAdd(Viewer.ViewTarget);
+
+		if (const APlayerController* PlayerController = Cast<APlayerController>(Viewer.InViewer))
+		{
+			ViewerActors.ConditionalAdd(PlayerController->PlayerState);
+		}
+	}
+
+	Params.OutGatheredReplicationLists.AddReplicationActorList(ViewerActors);
+}
+
+void UPDPReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// The graph is frame based, so every replicated class gets its NetUpdateFrequency converted to a replication period.
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+		// Classes that never update keep the default period.
+		if (!ActorCDO || !ActorCDO->GetIsReplicated() || ActorCDO->NetUpdateFrequency <= 0.0f)
+		{
+			continue;
+		}
+
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		FClassReplicationInfo ClassInfo;
+		ClassInfo.ReplicationPeriodFrame = FMath::Max<uint32>(static_cast<uint32>(FMath::RoundToFloat(NetDriver->NetServerMaxTickRate / ActorCDO->NetUpdateFrequency)), 1);
+		ClassInfo.SetCullDistanceSquared(ActorCDO->bAlwaysRelevant || ActorCDO->bOnlyRelevantToOwner ? 0.0f : ActorCDO->NetCullDistanceSquared);
+
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UPDPReplicationGraph::InitGlobalGraphNodes()
+{
+	PreAllocateRepList(3, 12);
+	PreAllocateRepList(6, 12);
+	PreAllocateRepList(128, 64);
+	PreAllocateRepList(512, 16);
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = GridSpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	PlayerStateNode = CreateNewNode<UReplicationGraphNode_PlayerStateFrequencyLimiter>();
+	AddGlobalGraphNode(PlayerStateNode);
+}
+
+void UPDPReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	UPDPReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantConnectionNode = CreateNewNode<UPDPReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantConnectionNode, RepGraphConnection);
+
+	AlwaysRelevantForConnectionList.Emplace(RepGraphConnection->NetConnection, AlwaysRelevantConnectionNode);
+}
+
+void UPDPReplicationGraph::RemoveClientConnection(UNetConnection* NetConnection)
+{
+	AlwaysRelevantForConnectionList.RemoveAllSwap([NetConnection](const FConnectionAlwaysRelevantNodePair& Pair)
+	{
+		return Pair.NetConnection == NetConnection;
+	});
+
+	Super::RemoveClientConnection(NetConnection);
+}
+
+bool UPDPReplicationGraph::IsMapGeometry(const AActor* Actor) const
+{
+	return Actor->IsA<AStaticMeshActor>() || Actor->IsA<ABrush>();
+}
+
+UReplicationGraphNode* UPDPReplicationGraph::FindAlwaysRelevantNodeForConnection(const UNetConnection* NetConnection) const
+{
+	const FConnectionAlwaysRelevantNodePair* Pair = AlwaysRelevantForConnectionList.FindByKey(NetConnection);
+	return Pair ? Pair->Node : nullptr;
+}
+
+void UPDPReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	AActor* Actor = ActorInfo.Actor;
+
+	// Player controllers and player states are gathered per viewer and by the player state node.
+	if (IsMapGeometry(Actor) || Actor->IsA<APlayerController>() || Actor->IsA<APlayerState>())
+	{
+		return;
+	}
+
+	if (Actor->bAlwaysRelevant)
+	{
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+	}
+	else if (Actor->bOnlyRelevantToOwner)
+	{
+		ActorsWithoutNetConnection.Add(Actor);
+	}
+	else
+	{
+		// Awake actors are treated as moving, dormant ones (corpses) as static actors of their cell.
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+	}
+}
+
+void UPDPReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	AActor* Actor = ActorInfo.Actor;
+
+	if (IsMapGeometry(Actor) || Actor->IsA<APlayerController>() || Actor->IsA<APlayerState>())
+	{
+		return;
+	}
+
+	if (Actor->bAlwaysRelevant)
+	{
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+	}
+	else if (Actor->bOnlyRelevantToOwner)
+	{
+		ActorsWithoutNetConnection.Remove(Actor);
+
+		if (UReplicationGraphNode* Node = FindAlwaysRelevantNodeForConnection(Actor->GetNetConnection()))
+		{
+			Node->NotifyRemoveNetworkActor(ActorInfo);
+		}
+	}
+	else
+	{
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+	}
+}
+
+int32 UPDPReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PDPRepGraph_ServerReplicateActors);
+
+	// Route the actors that got an owning connection since the last frame.
+	for (int32 Index = ActorsWithoutNetConnection.Num() - 1; Index >= 0; --Index)
+	{
+		AActor* Actor = ActorsWithoutNetConnection[Index];
+		if (!IsValid(Actor))
+		{
+			ActorsWithoutNetConnection.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		if (UReplicationGraphNode* Node = FindAlwaysRelevantNodeForConnection(Actor->GetNetConnection()))
+		{
+			Node->NotifyAddNetworkActor(FNewReplicatedActorInfo(Actor));
+			ActorsWithoutNetConnection.RemoveAtSwap(Index, 1, false);
+		}
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 NumReplicated = Super::ServerReplicateActors(DeltaSeconds);
+	const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	LastReplicationTimeMs = ElapsedMs;
+
+	// The connections are gathered and replicated inside the base class, only their average can be measured here.
+	const int32 NumConnections = Connections.Num();
+	SET_DWORD_STAT(STAT_PDPRepGraph_Connections, NumConnections);
+	SET_FLOAT_STAT(STAT_PDPRepGraph_AverageCostPerConnection, NumConnections > 0 ? ElapsedMs / NumConnections : 0.0);
+
+	return NumReplicated;
+}
+
+void UPDPReplicationGraph::SetActorReplicationRate(AActor* Actor, float NetUpdateFrequency, float NetPriority, bool bScaleByDistance)
+{
+	FGlobalActorReplicationInfo* GlobalInfo = GlobalActorReplicationInfoMap.Find(Actor);
+	if (!GlobalInfo || NetUpdateFrequency <= 0.0f)
+	{
+		return;
+	}
+
+	const uint32 ReplicationPeriodFrame = FMath::Max<uint32>(static_cast<uint32>(FMath::RoundToFloat(NetDriver->NetServerMaxTickRate / NetUpdateFrequency)), 1);
+	GlobalInfo->Settings.ReplicationPeriodFrame = ReplicationPeriodFrame;
+
+	// Lower priorities replicate first, a higher net priority shrinks the distance part of it.
+	GlobalInfo->Settings.DistancePriorityScale = 1.0f / FMath::Max(NetPriority, KINDA_SMALL_NUMBER);
+
+	// Connections copy the global period the first time they gather the actor, later changes are set on each of them.
+	const FVector ActorLocation = Actor->GetActorLocation();
+	for (UNetReplicationGraphConnection* ConnectionManager : Connections)
+	{
+		FConnectionReplicationActorInfo* ConnectionInfo = ConnectionManager->ActorInfoMap.Find(Actor);
+		if (!ConnectionInfo)
+		{
+			continue;
+		}
+
+		const AActor* ViewTarget = ConnectionManager->NetConnection ? ConnectionManager->NetConnection->ViewTarget : nullptr;
+
+		float PeriodScale = 1.0f;
+		if (bScaleByDistance && ViewTarget && ViewTarget != Actor)
+		{
+			const float Distance = FVector::Dist(ViewTarget->GetActorLocation(), ActorLocation);
+			PeriodScale = FMath::GetMappedRangeValueClamped(FVector2D(ReplicationPeriodScaleMinDistance, ReplicationPeriodScaleMaxDistance), FVector2D(1.0f, MaxReplicationPeriodScale), Distance);
+		}
+
+		ConnectionInfo->ReplicationPeriodFrame = FMath::Max<uint32>(static_cast<uint32>(FMath::RoundToFloat(ReplicationPeriodFrame * PeriodScale)), 1);
+	}
+}
+
+bool UPDPReplicationGraph::ProcessRemoteFunction(AActor* Actor, UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack, UObject* SubObject)
+{
+	UPDPNetAccountingSubsystem* NetAccounting = GetWorld() ? GetWorld()->GetSubsystem<UPDPNetAccountingSubsystem>() : nullptr;
+	UNetConnection* Connection = Actor ? Actor->GetNetConnection() : nullptr;
+
+	// Multicasts are split per connection by the graph itself, they are not accounted.
+	if (!NetAccounting || !NetAccounting->IsEnabled() || !Connection || Function->HasAnyFunctionFlags(FUNC_NetMulticast))
+	{
+		return Super::ProcessRemoteFunction(Actor, Function, Parameters, OutParms, Stack, SubObject);
+	}
+
+	const int64 StartBits = Connection->SendBuffer.GetNumBits();
+	const int64 StartTotalBytes = Connection->OutTotalBytes;
+
+	const bool bProcessed = Super::ProcessRemoteFunction(Actor, Function, Parameters, OutParms, Stack, SubObject);
+	if (!bProcessed)
+	{
+		return false;
+	}
+
+	// When the bunch didn't fit, the pending packet was sent first, and a large reliable RPC such as the
+	// kill-cam is split into partial bunches over several packets. The packets sent during the call hold
+	// what was pending before it and the first parts of the RPC, the send buffer holds the rest.
+	const int64 EndBits = Connection->SendBuffer.GetNumBits();
+	const int64 Bits = (Connection->OutTotalBytes - StartTotalBytes) * 8 + EndBits - StartBits;
+
+	// Nothing written means the RPC was dropped, typically an unreliable one on a saturated connection.
+	const UActorChannel* Channel = Connection->FindActorChannelRef(Actor);
+	const bool bReliable = Function->HasAnyFunctionFlags(FUNC_NetReliable);
+	NetAccounting->RecordOutgoingRPC(Connection, Function->GetFName(), Bits, Bits <= 0, bReliable && Channel ? Channel->NumOutRec : 0);
+
+	return true;
+}
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "PDPReplicationGraph.generated.h"
+
+DECLARE_STATS_GROUP(TEXT("PDPReplicationGraph"), STATGROUP_PDPReplicationGraph, STATCAT_Advanced);
+
+/**
+ * Always relevant to the owning connection: its player controller, view target and player state.
+ * The view target is the possessed character, which carries the health and ammo the HUD shows.
+ */
+UCLASS()
+class PDPMULTIPLAYER_API UPDPReplicationGraphNode_AlwaysRelevant_ForConnection : public UReplicationGraphNode_AlwaysRelevant_ForConnection
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+private:
+	FActorRepListRefView ViewerActors;
+};
+
+/**
+ * Replication graph of the match:
+ *	- characters are spatialized in a grid, corpses go dormant in the grid cells once they stop replicating
+ *	- player states are replicated to everybody by a frequency limited node, and every frame to their owner
+ *	- actors that are only relevant to their owner go to their connection node
+ *	- map geometry is never routed
+ */
+UCLASS(transient, config=Engine)
+class PDPMULTIPLAYER_API UPDPReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RemoveClientConnection(UNetConnection* NetConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	/** Also reports the bits every unicast RPC adds to its connection to the network accounting. */
+	virtual bool ProcessRemoteFunction(class AActor* Actor, UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack, class UObject* SubObject) override;
+
+	/**
+	 * Replicates Actor at NetUpdateFrequency instead of the rate of its class, and sorts it by NetPriority.
+	 * With bScaleByDistance, the rate is lowered for each connection whose viewer is far from the actor.
+	 */
+	void SetActorReplicationRate(AActor* Actor, float NetUpdateFrequency, float NetPriority, bool bScaleByDistance);
+
+	/** Milliseconds the last frame spent gathering and replicating actors for all connections. */
+	FORCEINLINE float GetLastReplicationTimeMs() const { return LastReplicationTimeMs; }
+
+	UPROPERTY(config)
+	float GridCellSize = 10000.0f;
+
+	/** Minimum world coordinate of the grid. Actors below it are clamped into the first cells. */
+	UPROPERTY(config)
+	FVector2D GridSpatialBias = FVector2D(-100000.0f, -100000.0f);
+
+	/** Viewer distance from which the replication period of an actor set by SetActorReplicationRate starts to grow. */
+	UPROPERTY(config)
+	float ReplicationPeriodScaleMinDistance = 3000.0f;
+
+	/** Viewer distance at which the replication period reaches MaxReplicationPeriodScale. */
+	UPROPERTY(config)
+	float ReplicationPeriodScaleMaxDistance = 15000.0f;
+
+	UPROPERTY(config)
+	float MaxReplicationPeriodScale = 4.0f;
+
+private:
+	struct FConnectionAlwaysRelevantNodePair
+	{
+		FConnectionAlwaysRelevantNodePair() = default;
+		FConnectionAlwaysRelevantNodePair(UNetConnection* InConnection, UPDPReplicationGraphNode_AlwaysRelevant_ForConnection* InNode) : NetConnection(InConnection), Node(InNode) { }
+
+		bool operator==(const UNetConnection* InConnection) const { return NetConnection == InConnection; }
+
+		UNetConnection* NetConnection = nullptr;
+		UPDPReplicationGraphNode_AlwaysRelevant_ForConnection* Node = nullptr;
+	};
+
+	bool IsMapGeometry(const AActor* Actor) const;
+
+	UReplicationGraphNode* FindAlwaysRelevantNodeForConnection(const UNetConnection* NetConnection) const;
+
+	UPROPERTY()
+	UReplicationGraphNode_GridSpatialization2D* GridNode = nullptr;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode = nullptr;
+
+	UPROPERTY()
+	UReplicationGraphNode_PlayerStateFrequencyLimiter* PlayerStateNode = nullptr;
+
+	TArray<FConnectionAlwaysRelevantNodePair> AlwaysRelevantForConnectionList;
+
+	/** Actors that are only relevant to their owner and are still waiting for it to get a connection. */
+	UPROPERTY()
+	TArray<AActor*> ActorsWithoutNetConnection;
+
+	float LastReplicationTimeMs = 0.0f;
+};
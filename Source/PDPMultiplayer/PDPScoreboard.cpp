@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPScoreboard.h"
+
+#include "PDPGameState.h"
+
+void FPDPScoreboardEntry::PreReplicatedRemove(const FPDPScoreboard& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->NotifyScoreboardEntryRemoved(*this);
+	}
+}
+
+void FPDPScoreboardEntry::PostReplicatedAdd(const FPDPScoreboard& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->NotifyScoreboardEntryChanged(*this);
+	}
+}
+
+void FPDPScoreboardEntry::PostReplicatedChange(const FPDPScoreboard& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->NotifyScoreboardEntryChanged(*this);
+	}
+}
+
+void FPDPScoreboard::SetEntry(APlayerState* PlayerState, int32 Kills, int32 Deaths, int32 Score)
+{
+	if (!PlayerState)
+	{
+		return;
+	}
+
+	FPDPScoreboardEntry* Entry = Entries.FindByPredicate([PlayerState](const FPDPScoreboardEntry& Row) { return Row.PlayerState == PlayerState; });
+	if (!Entry)
+	{
+		Entry = &Entries.AddDefaulted_GetRef();
+		Entry->PlayerState = PlayerState;
+	}
+
+	Entry->Kills = Kills;
+	Entry->Deaths = Deaths;
+	Entry->Score = Score;
+	MarkItemDirty(*Entry);
+
+	// Replication callbacks only run on clients, a listen server updates its own scoreboard here.
+	if (Owner)
+	{
+		Owner->NotifyScoreboardEntryChanged(*Entry);
+	}
+}
+
+void FPDPScoreboard::RemoveEntry(APlayerState* PlayerState)
+{
+	const int32 Index = Entries.IndexOfByPredicate([PlayerState](const FPDPScoreboardEntry& Row) { return Row.PlayerState == PlayerState; });
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (Owner)
+	{
+		Owner->NotifyScoreboardEntryRemoved(Entries[Index]);
+	}
+
+	Entries.RemoveAtSwap(Index);
+	MarkArrayDirty();
+}
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "PDPScoreboard.generated.h"
+
+class APDPGameState;
+class APlayerState;
+
+/** Scoreboard row of a player. */
+USTRUCT(BlueprintType)
+struct PDPMULTIPLAYER_API FPDPScoreboardEntry : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	APlayerState* PlayerState = nullptr;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Kills = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Deaths = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Score = 0;
+
+	void PreReplicatedRemove(const struct FPDPScoreboard& InArraySerializer);
+	void PostReplicatedAdd(const struct FPDPScoreboard& InArraySerializer);
+	void PostReplicatedChange(const struct FPDPScoreboard& InArraySerializer);
+};
+
+/**
+ * Rows of every player, delta replicated: a kill only sends the rows of the killer and the victim,
+ * and clients are notified row by row.
+ */
+USTRUCT()
+struct PDPMULTIPLAYER_API FPDPScoreboard : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	/** Adds the row of PlayerState, or updates it. Server only. */
+	void SetEntry(APlayerState* PlayerState, int32 Kills, int32 Deaths, int32 Score);
+	void RemoveEntry(APlayerState* PlayerState);
+
+	FORCEINLINE const TArray<FPDPScoreboardEntry>& GetEntries() const { return Entries; }
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FPDPScoreboardEntry, FPDPScoreboard>(Entries, DeltaParms, *this);
+	}
+
+private:
+	friend class APDPGameState;
+
+	UPROPERTY()
+	TArray<FPDPScoreboardEntry> Entries;
+
+	/** Notified of every row change, on clients by replication and on the server when a row is set. */
+	UPROPERTY(NotReplicated)
+	APDPGameState* Owner = nullptr;
+};
+
+template<>
+struct TStructOpsTypeTraits<FPDPScoreboard> : public TStructOpsTypeTraitsBase2<FPDPScoreboard>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
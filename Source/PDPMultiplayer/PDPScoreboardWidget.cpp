@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPScoreboardWidget.h"
+#include "PDPGameState.h"
+#include "Engine/World.h"
+
+void UPDPScoreboardWidget::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	APDPGameState* NewGameState = World->GetGameState<APDPGameState>();
+	if (!NewGameState)
+	{
+		return;
+	}
+
+	GameState = NewGameState;
+	NewGameState->OnScoreboardEntryChanged.AddDynamic(this, &UPDPScoreboardWidget::OnScoreboardEntryChanged);
+	NewGameState->OnScoreboardEntryRemoved.AddDynamic(this, &UPDPScoreboardWidget::OnScoreboardEntryRemoved);
+
+	for (const FPDPScoreboardEntry& Entry : NewGameState->GetScoreboardEntries())
+	{
+		UpdateRow(Entry);
+	}
+}
+
+void UPDPScoreboardWidget::NativeDestruct()
+{
+	if (APDPGameState* OldGameState = GameState.Get())
+	{
+		OldGameState->OnScoreboardEntryChanged.RemoveDynamic(this, &UPDPScoreboardWidget::OnScoreboardEntryChanged);
+		OldGameState->OnScoreboardEntryRemoved.RemoveDynamic(this, &UPDPScoreboardWidget::OnScoreboardEntryRemoved);
+	}
+
+	GameState.Reset();
+
+	Super::NativeDestruct();
+}
+
+void UPDPScoreboardWidget::OnScoreboardEntryChanged(const FPDPScoreboardEntry& Entry)
+{
+	// A row can arrive before the player state it points to has replicated.
+	if (Entry.PlayerState)
+	{
+		UpdateRow(Entry);
+	}
+}
+
+void UPDPScoreboardWidget::OnScoreboardEntryRemoved(APlayerState* PlayerState)
+{
+	RemoveRow(PlayerState);
+}
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "PDPScoreboard.h"
+#include "PDPScoreboardWidget.generated.h"
+
+class APDPGameState;
+/**
+ * Scoreboard of the match. Rows are updated one at a time as the game state reports them,
+ * the board is only filled from scratch when the widget is constructed.
+ */
+UCLASS()
+class PDPMULTIPLAYER_API UPDPScoreboardWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void NativeConstruct() override;
+	virtual void NativeDestruct() override;
+
+	/** Adds the row of Entry.PlayerState or updates it. */
+	UFUNCTION(BlueprintImplementableEvent)
+	void UpdateRow(const FPDPScoreboardEntry& Entry);
+
+	UFUNCTION(BlueprintImplementableEvent)
+	void RemoveRow(APlayerState* PlayerState);
+
+private:
+	UFUNCTION()
+	void OnScoreboardEntryChanged(const FPDPScoreboardEntry& Entry);
+
+	UFUNCTION()
+	void OnScoreboardEntryRemoved(APlayerState* PlayerState);
+
+	TWeakObjectPtr<APDPGameState> GameState;
+};
@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPShotTraceSubsystem.h"
+
+#include "DrawDebugHelpers.h"
+#include "PDPMultiplayerCharacter.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+#if !UE_BUILD_SHIPPING
+
+static int32 GShotTracesShow = 0;
+static FAutoConsoleVariableRef CVarShotTracesShow(
+	TEXT("PDP.ShotTraces.Show"),
+	GShotTracesShow,
+	TEXT("Draw the last shot traces of the client and the server, and highlight the ones they disagree on."),
+	ECVF_Cheat);
+
+static int32 GShotTracesMaxTraces = 64;
+static FAutoConsoleVariableRef CVarShotTracesMaxTraces(
+	TEXT("PDP.ShotTraces.MaxTraces"),
+	GShotTracesMaxTraces,
+	TEXT("Shot traces kept by each world, the oldest one is overwritten by a new shot."),
+	ECVF_Cheat);
+
+static float GShotTracesDuration = 10.0f;
+static FAutoConsoleVariableRef CVarShotTracesDuration(
+	TEXT("PDP.ShotTraces.Duration"),
+	GShotTracesDuration,
+	TEXT("Seconds a shot trace stays drawn."),
+	ECVF_Cheat);
+
+#endif
+
+bool UPDPShotTraceSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+#if UE_BUILD_SHIPPING
+	return false;
+#else
+	return Super::ShouldCreateSubsystem(Outer);
+#endif
+}
+
+void UPDPShotTraceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UPDPShotTraceSubsystem::OnWorldPostActorTick);
+}
+
+void UPDPShotTraceSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	Traces.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UPDPShotTraceSubsystem::IsEnabled()
+{
+#if UE_BUILD_SHIPPING
+	return false;
+#else
+	return GShotTracesShow != 0;
+#endif
+}
+
+void UPDPShotTraceSubsystem::RecordTrace(const APDPMultiplayerCharacter* Shooter, uint16 ShotId, const FVector& Start, const FVector& End, const AActor* HitActor, const FVector& HitLocation)
+{
+#if !UE_BUILD_SHIPPING
+	const UWorld* World = GetWorld();
+	if (!IsEnabled() || !Shooter || !World)
+	{
+		return;
+	}
+
+	const int32 MaxTraces = FMath::Max(GShotTracesMaxTraces, 1);
+	if (Traces.Num() > MaxTraces)
+	{
+		Traces.Reset();
+		NextTraceIndex = 0;
+	}
+
+	// The ring only grows until it is full, then the oldest trace is overwritten.
+	if (Traces.Num() < MaxTraces)
+	{
+		NextTraceIndex = Traces.AddDefaulted();
+	}
+
+	FShotTrace& Trace = Traces[NextTraceIndex];
+	Trace.ShooterId = APDPMultiplayerCharacter::GetPlayerId(Shooter);
+	Trace.ShotId = ShotId;
+	Trace.bServer = World->GetNetMode() != NM_Client;
+	Trace.Start = Start;
+	Trace.End = End;
+	Trace.HitLocation = HitActor ? HitLocation : End;
+	Trace.HitPlayerId = APDPMultiplayerCharacter::GetPlayerId(HitActor);
+	Trace.bHit = HitActor != nullptr;
+	Trace.Time = World->GetRealTimeSeconds();
+
+	NextTraceIndex = (NextTraceIndex + 1) % MaxTraces;
+#endif
+}
+
+const UPDPShotTraceSubsystem::FShotTrace* UPDPShotTraceSubsystem::FindServerTrace(int32 ShooterId, uint16 ShotId) const
+{
+	return Traces.FindByPredicate([ShooterId, ShotId](const FShotTrace& Trace) { return Trace.bServer && Trace.ShooterId == ShooterId && Trace.ShotId == ShotId; });
+}
+
+void UPDPShotTraceSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || !IsEnabled() || Traces.Num() == 0 || World->GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	DrawTraces(World);
+}
+
+void UPDPShotTraceSubsystem::DrawTraces(UWorld* World) const
+{
+#if !UE_BUILD_SHIPPING
+	const UPDPShotTraceSubsystem* ServerSubsystem = FindServerSubsystem();
+	const double Now = World->GetRealTimeSeconds();
+
+	// Lines last a single frame, they are drawn again from the ring every frame.
+	for (const FShotTrace& Trace : Traces)
+	{
+		if (Now - Trace.Time > GShotTracesDuration)
+		{
+			continue;
+		}
+
+		if (Trace.bServer)
+		{
+			const FColor Color = Trace.bHit ? FColor::Green : FColor::Red;
+			DrawDebugLine(World, Trace.Start, Trace.HitLocation, Color);
+			DrawDebugPoint(World, Trace.HitLocation, 8.0f, Color);
+			continue;
+		}
+
+		const FShotTrace* ServerTrace = ServerSubsystem ? ServerSubsystem->FindServerTrace(Trace.ShooterId, Trace.ShotId) : nullptr;
+		if (ServerTrace && ServerTrace->HitPlayerId != Trace.HitPlayerId)
+		{
+			DrawDebugLine(World, Trace.Start, Trace.HitLocation, FColor::Yellow);
+			DrawDebugPoint(World, Trace.HitLocation, 8.0f, FColor::Yellow);
+
+			const FColor ServerColor = ServerTrace->bHit ? FColor::Green : FColor::Red;
+			DrawDebugLine(World, ServerTrace->Start, ServerTrace->HitLocation, ServerColor);
+			DrawDebugPoint(World, ServerTrace->HitLocation, 8.0f, ServerColor);
+			continue;
+		}
+
+		DrawDebugLine(World, Trace.Start, Trace.HitLocation, FColor::Cyan);
+	}
+#endif
+}
+
+const UPDPShotTraceSubsystem* UPDPShotTraceSubsystem::FindServerSubsystem() const
+{
+	const UWorld* World = GetWorld();
+	if (!GEngine || !World || World->GetNetMode() != NM_Client)
+	{
+		return nullptr;
+	}
+
+	for (const FWorldContext& WorldContext : GEngine->GetWorldContexts())
+	{
+		const UWorld* ServerWorld = WorldContext.World();
+		if (ServerWorld && ServerWorld != World && ServerWorld->IsGameWorld() && ServerWorld->GetNetMode() != NM_Client)
+		{
+			return ServerWorld->GetSubsystem<UPDPShotTraceSubsystem>();
+		}
+	}
+
+	return nullptr;
+}
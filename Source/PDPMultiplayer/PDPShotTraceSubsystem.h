@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PDPShotTraceSubsystem.generated.h"
+
+class APDPMultiplayerCharacter;
+
+/**
+ * Debug view of the last shots, shown with PDP.ShotTraces.Show 1. Each world keeps its traces in a ring of
+ * PDP.ShotTraces.MaxTraces entries and draws them every frame as non-persistent lines: client traces in cyan,
+ * server traces in green when they hit and red when they miss. A client trace whose server result disagrees,
+ * hit on one side only or another character hit, is drawn in yellow next to the server trace.
+ *
+ * Server results are matched only when the server runs in the same process, as in PIE. Never created in Shipping.
+ */
+UCLASS()
+class PDPMULTIPLAYER_API UPDPShotTraceSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	struct FShotTrace
+	{
+		int32 ShooterId = INDEX_NONE;
+		uint16 ShotId = 0;
+		bool bServer = false;
+		FVector Start = FVector::ZeroVector;
+		FVector End = FVector::ZeroVector;
+		FVector HitLocation = FVector::ZeroVector;
+		/** Player id of the character hit, INDEX_NONE when nobody was hit. */
+		int32 HitPlayerId = INDEX_NONE;
+		bool bHit = false;
+		double Time = 0.0;
+	};
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	static bool IsEnabled();
+
+	/** @param HitActor	Actor the trace stopped on at HitLocation, nullptr for a miss */
+	void RecordTrace(const APDPMultiplayerCharacter* Shooter, uint16 ShotId, const FVector& Start, const FVector& End, const AActor* HitActor, const FVector& HitLocation);
+
+	const FShotTrace* FindServerTrace(int32 ShooterId, uint16 ShotId) const;
+
+private:
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void DrawTraces(UWorld* World) const;
+
+	/** Shot traces of the server world running in this process, if any. */
+	const UPDPShotTraceSubsystem* FindServerSubsystem() const;
+
+	TArray<FShotTrace> Traces;
+	int32 NextTraceIndex = 0;
+
+	FDelegateHandle PostActorTickHandle;
+};
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPSkeletalMeshComponent.h"
+
+#include "PDPAnimationBudgetSubsystem.h"
+#include "Engine/World.h"
+#include "Misc/Crc.h"
+
+void UPDPSkeletalMeshComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	UWorld* World = GetWorld();
+	if (!World || !World->IsGameWorld())
+	{
+		return;
+	}
+
+	// Unique ids of meshes spawned together are evenly spaced, they are hashed so the phases don't line up.
+	const uint32 UniqueID = GetUniqueID();
+	TickPhase = FCrc::MemCrc32(&UniqueID, sizeof(UniqueID));
+
+	if (World->GetNetMode() == NM_DedicatedServer)
+	{
+		VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+		return;
+	}
+
+	if (UPDPAnimationBudgetSubsystem* AnimationBudget = World->GetSubsystem<UPDPAnimationBudgetSubsystem>())
+	{
+		AnimationBudget->RegisterMesh(this);
+	}
+}
+
+void UPDPSkeletalMeshComponent::OnUnregister()
+{
+	UWorld* World = GetWorld();
+	if (UPDPAnimationBudgetSubsystem* AnimationBudget = World ? World->GetSubsystem<UPDPAnimationBudgetSubsystem>() : nullptr)
+	{
+		AnimationBudget->UnregisterMesh(this);
+	}
+
+	Super::OnUnregister();
+}
+
+void UPDPSkeletalMeshComponent::SetAnimationTickRate(int32 TickRate)
+{
+	AnimationTickRate = FMath::Max(TickRate, 1);
+}
+
+void UPDPSkeletalMeshComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	if (AnimationTickRate > 1 && (GFrameCounter + TickPhase) % AnimationTickRate != 0)
+	{
+		SkippedDeltaTime += DeltaTime;
+		return;
+	}
+
+	const float AccumulatedDeltaTime = DeltaTime + SkippedDeltaTime;
+	SkippedDeltaTime = 0.0f;
+
+	// Only the game thread part of the tick is measured, see UPDPAnimationBudgetSubsystem.
+	const double StartTime = FPlatformTime::Seconds();
+
+	Super::TickComponent(AccumulatedDeltaTime, TickType, ThisTickFunction);
+
+	UWorld* World = GetWorld();
+	if (UPDPAnimationBudgetSubsystem* AnimationBudget = World ? World->GetSubsystem<UPDPAnimationBudgetSubsystem>() : nullptr)
+	{
+		AnimationBudget->ReportTickTime(FPlatformTime::Seconds() - StartTime);
+	}
+}
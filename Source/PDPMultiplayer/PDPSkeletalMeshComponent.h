@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "PDPSkeletalMeshComponent.generated.h"
+
+/**
+ * Character mesh whose animation ticks at the rate given by the animation budget. Skipped frames add up
+ * into the delta time of the next tick, so animations keep their speed at any rate.
+ *
+ * A dedicated server never refreshes the pose: hits are validated against the capsules kept by the lag
+ * compensation, so bones are only needed once the character ragdolls.
+ */
+UCLASS(ClassGroup=(PDP), meta=(BlueprintSpawnableComponent))
+class PDPMULTIPLAYER_API UPDPSkeletalMeshComponent : public USkeletalMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Ticks the animation once every TickRate frames. */
+	void SetAnimationTickRate(int32 TickRate);
+
+	FORCEINLINE int32 GetAnimationTickRate() const { return AnimationTickRate; }
+
+protected:
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+
+private:
+	int32 AnimationTickRate = 1;
+
+	/** Spreads the meshes ticking at the same rate over different frames, fixed for the lifetime of the mesh. */
+	uint32 TickPhase = 0;
+
+	float SkippedDeltaTime = 0.0f;
+};
@@ -0,0 +1,226 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPSpawnPointSubsystem.h"
+
+#include "EngineUtils.h"
+#include "PDPMultiplayer.h"
+#include "PDPMultiplayerCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/PlayerStart.h"
+
+void UPDPSpawnPointSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (UWorld* World = GetWorld())
+	{
+		ActorSpawnedHandle = World->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UPDPSpawnPointSubsystem::OnActorSpawned));
+	}
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UPDPSpawnPointSubsystem::OnLevelAdded);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UPDPSpawnPointSubsystem::OnLevelRemoved);
+}
+
+void UPDPSpawnPointSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+
+	SpawnPoints.Reset();
+	Grid.Reset();
+
+	Super::Deinitialize();
+}
+
+void UPDPSpawnPointSubsystem::RegisterPlayerStart(APlayerStart* PlayerStart)
+{
+	if (!PlayerStart || SpawnPoints.ContainsByPredicate([PlayerStart](const FSpawnPoint& SpawnPoint) { return SpawnPoint.PlayerStart == PlayerStart; }))
+	{
+		return;
+	}
+
+	// Player starts don't move, their location is read once.
+	FSpawnPoint& SpawnPoint = SpawnPoints.AddDefaulted_GetRef();
+	SpawnPoint.PlayerStart = PlayerStart;
+	SpawnPoint.Location = PlayerStart->GetActorLocation();
+
+	bGridDirty = true;
+}
+
+void UPDPSpawnPointSubsystem::BuildRegistry()
+{
+	bRegistryBuilt = true;
+
+	for (TActorIterator<APlayerStart> It(GetWorld()); It; ++It)
+	{
+		RegisterPlayerStart(*It);
+	}
+}
+
+void UPDPSpawnPointSubsystem::OnActorSpawned(AActor* Actor)
+{
+	if (bRegistryBuilt)
+	{
+		RegisterPlayerStart(Cast<APlayerStart>(Actor));
+	}
+}
+
+void UPDPSpawnPointSubsystem::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (World != GetWorld() || !Level || !bRegistryBuilt)
+	{
+		return;
+	}
+
+	for (AActor* Actor : Level->Actors)
+	{
+		RegisterPlayerStart(Cast<APlayerStart>(Actor));
+	}
+}
+
+void UPDPSpawnPointSubsystem::OnLevelRemoved(ULevel* Level, UWorld* World)
+{
+	if (World != GetWorld())
+	{
+		return;
+	}
+
+	// A null level means the whole world is being torn down.
+	SpawnPoints.RemoveAllSwap([Level](const FSpawnPoint& SpawnPoint)
+	{
+		return !Level || !SpawnPoint.PlayerStart.IsValid() || SpawnPoint.PlayerStart->GetLevel() == Level;
+	});
+
+	bGridDirty = true;
+}
+
+FIntPoint UPDPSpawnPointSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / SafeRadius), FMath::FloorToInt(Location.Y / SafeRadius));
+}
+
+void UPDPSpawnPointSubsystem::BuildGrid()
+{
+	bGridDirty = false;
+
+	Grid.Reset();
+	for (int32 Index = 0; Index < SpawnPoints.Num(); ++Index)
+	{
+		Grid.FindOrAdd(GetCell(SpawnPoints[Index].Location)).Add(Index);
+	}
+}
+
+void UPDPSpawnPointSubsystem::FindNearestEnemies(const AController* Controller)
+{
+	const float SafeRadiusSquared = FMath::Square(SafeRadius);
+	for (FSpawnPoint& SpawnPoint : SpawnPoints)
+	{
+		SpawnPoint.NearestEnemyDistanceSquared = SafeRadiusSquared;
+	}
+
+	// The characters are found through the controllers, which leaves out the pool. A corpse keeps its controller
+	// until the respawn and is skipped as dead.
+	for (FConstControllerIterator It = GetWorld()->GetControllerIterator(); It; ++It)
+	{
+		const AController* OtherController = It->Get();
+		const APDPMultiplayerCharacter* Character = OtherController ? Cast<APDPMultiplayerCharacter>(OtherController->GetPawn()) : nullptr;
+		if (!Character || Character->IsDead() || OtherController == Controller)
+		{
+			continue;
+		}
+
+		// The cells are as large as the radius, so the starts it covers are in the 3x3 cells around the enemy.
+		const FVector EnemyLocation = Character->GetActorLocation();
+		const FIntPoint EnemyCell = GetCell(EnemyLocation);
+		for (int32 Y = EnemyCell.Y - 1; Y <= EnemyCell.Y + 1; ++Y)
+		{
+			for (int32 X = EnemyCell.X - 1; X <= EnemyCell.X + 1; ++X)
+			{
+				const TArray<int32>* CellSpawnPoints = Grid.Find(FIntPoint(X, Y));
+				if (!CellSpawnPoints)
+				{
+					continue;
+				}
+
+				for (const int32 Index : *CellSpawnPoints)
+				{
+					FSpawnPoint& SpawnPoint = SpawnPoints[Index];
+					SpawnPoint.NearestEnemyDistanceSquared = FMath::Min(SpawnPoint.NearestEnemyDistanceSquared, FVector::DistSquared(SpawnPoint.Location, EnemyLocation));
+				}
+			}
+		}
+	}
+}
+
+float UPDPSpawnPointSubsystem::ScoreSpawnPoint(const FSpawnPoint& SpawnPoint, float Now) const
+{
+	float Score = FMath::Sqrt(SpawnPoint.NearestEnemyDistanceSquared) / SafeRadius;
+
+	const float TimeSinceUse = Now - SpawnPoint.LastUseTime;
+	if (TimeSinceUse < RecentUseWindow)
+	{
+		Score -= RecentUsePenalty * (1.0f - TimeSinceUse / RecentUseWindow);
+	}
+
+	return Score;
+}
+
+APlayerStart* UPDPSpawnPointSubsystem::ChooseSpawnPoint(const AController* Controller)
+{
+	PDP_SCOPE_CYCLE_COUNTER(STAT_PDP_ChooseSpawnPoint, ChooseSpawnPoint);
+
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return nullptr;
+	}
+
+	if (!bRegistryBuilt)
+	{
+		BuildRegistry();
+	}
+
+	// Destroyed starts are dropped here rather than when they are destroyed.
+	if (SpawnPoints.RemoveAllSwap([](const FSpawnPoint& SpawnPoint) { return !SpawnPoint.PlayerStart.IsValid(); }) > 0)
+	{
+		bGridDirty = true;
+	}
+
+	if (bGridDirty)
+	{
+		BuildGrid();
+	}
+
+	FindNearestEnemies(Controller);
+
+	const float Now = World->GetTimeSeconds();
+
+	FSpawnPoint* BestSpawnPoint = nullptr;
+	float BestScore = -MAX_FLT;
+
+	for (FSpawnPoint& SpawnPoint : SpawnPoints)
+	{
+		// The random part only breaks ties between equally safe starts.
+		const float Score = ScoreSpawnPoint(SpawnPoint, Now) + FMath::FRand() * KINDA_SMALL_NUMBER;
+		if (Score > BestScore)
+		{
+			BestScore = Score;
+			BestSpawnPoint = &SpawnPoint;
+		}
+	}
+
+	if (!BestSpawnPoint)
+	{
+		return nullptr;
+	}
+
+	BestSpawnPoint->LastUseTime = Now;
+	return BestSpawnPoint->PlayerStart.Get();
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PDPSpawnPointSubsystem.generated.h"
+
+class APlayerStart;
+
+/**
+ * Registry of the player starts of the world. It is built once and kept up to date as starts
+ * are spawned or their level is streamed in or out, so respawning never walks the actor list.
+ * Starts are bucketed in a grid of SafeRadius cells, so a respawn only scores the starts around
+ * each living enemy.
+ */
+UCLASS(config=Game)
+class PDPMULTIPLAYER_API UPDPSpawnPointSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void RegisterPlayerStart(APlayerStart* PlayerStart);
+
+	/**
+	 * Picks the start furthest from living enemies of Controller that was not used recently.
+	 * @return nullptr if the world has no player start.
+	 */
+	APlayerStart* ChooseSpawnPoint(const AController* Controller);
+
+	/** Enemies further than this from a start don't lower its score. */
+	UPROPERTY(config)
+	float SafeRadius = 2500.0f;
+
+	/** Seconds during which a start that was just used gets penalized. */
+	UPROPERTY(config)
+	float RecentUseWindow = 5.0f;
+
+	/** Score removed from a start used right now, fading out over RecentUseWindow. */
+	UPROPERTY(config)
+	float RecentUsePenalty = 0.5f;
+
+private:
+	struct FSpawnPoint
+	{
+		TWeakObjectPtr<APlayerStart> PlayerStart;
+		FVector Location = FVector::ZeroVector;
+		float LastUseTime = -MAX_FLT;
+
+		/** Scratch of ChooseSpawnPoint. */
+		float NearestEnemyDistanceSquared = 0.0f;
+	};
+
+	void BuildRegistry();
+	void OnActorSpawned(AActor* Actor);
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+	void OnLevelRemoved(ULevel* Level, UWorld* World);
+
+	FIntPoint GetCell(const FVector& Location) const;
+	void BuildGrid();
+
+	/** Lowers the NearestEnemyDistanceSquared of the starts within SafeRadius of the living enemies of Controller. */
+	void FindNearestEnemies(const AController* Controller);
+
+	float ScoreSpawnPoint(const FSpawnPoint& SpawnPoint, float Now) const;
+
+	TArray<FSpawnPoint> SpawnPoints;
+
+	/** Indices in SpawnPoints of the starts in each cell, rebuilt when SpawnPoints changes. */
+	TMap<FIntPoint, TArray<int32>> Grid;
+	bool bGridDirty = true;
+
+	bool bRegistryBuilt = false;
+
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+};
@@ -2,13 +2,23 @@
 
 
 #include "PDPStartPlayerController.h"
+#include "PDPPreloadSubsystem.h"
 #include "Blueprint/UserWidget.h"
+#include "Engine/GameInstance.h"
 
 void APDPStartPlayerController::BeginPlay()
 {
 	Super::BeginPlay();
 	
 	Client_DrawStartUI();
+
+	// The match is loaded in the background while the player is in the menu.
+	UGameInstance* GameInstance = GetGameInstance();
+	UPDPPreloadSubsystem* Preload = GameInstance ? GameInstance->GetSubsystem<UPDPPreloadSubsystem>() : nullptr;
+	if (Preload && IsLocalController())
+	{
+		Preload->StartPreload();
+	}
 }
 
 void APDPStartPlayerController::Destroyed()
@@ -20,11 +30,13 @@ void APDPStartPlayerController::Destroyed()
 
 void APDPStartPlayerController::Client_DrawStartUI_Implementation()
 {
+#if !UE_SERVER
 	UUserWidget* Widget = CreateWidget(this, StartWidget);
 	if (Widget)
 	{
 		Widget->AddToViewport();
 	}
+#endif
 	
 	SetShowMouseCursor(true);
 
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPWeaponComponent.h"
+
+#include "PDPWeaponDefinition.h"
+#include "Components/AudioComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Sound/SoundConcurrency.h"
+
+UPDPWeaponComponent::UPDPWeaponComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+const UPDPWeaponDefinition* UPDPWeaponComponent::GetDefinition() const
+{
+	return Definition ? Definition : GetDefault<UPDPWeaponDefinition>();
+}
+
+bool UPDPWeaponComponent::IsReadyToFire(float Tolerance) const
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return false;
+	}
+
+	return World->GetTimeSeconds() - LastFireTime >= GetDefinition()->FireInterval - Tolerance;
+}
+
+void UPDPWeaponComponent::NotifyFired()
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	// An early shot doesn't move the next one earlier, so the tolerance never adds up to a faster fire rate.
+	LastFireTime = FMath::Max(World->GetTimeSeconds(), LastFireTime + GetDefinition()->FireInterval);
+}
+
+void UPDPWeaponComponent::ResetCooldown()
+{
+	LastFireTime = -MAX_FLT;
+}
+
+uint8 UPDPWeaponComponent::GetMaxAmmo() const
+{
+	return GetDefinition()->MaxAmmo;
+}
+
+void UPDPWeaponComponent::PlayFireSound(bool bDryFire)
+{
+#if !UE_SERVER
+	const UPDPWeaponDefinition* WeaponDefinition = GetDefinition();
+	USoundBase* Sound = bDryFire ? WeaponDefinition->NoAmmoSound : WeaponDefinition->ShotSound;
+	if (!Sound)
+	{
+		return;
+	}
+
+	if (UAudioComponent* AudioComponent = AcquireAudioComponent())
+	{
+		AudioComponent->SetSound(Sound);
+		AudioComponent->Play();
+	}
+#endif
+}
+
+UAudioComponent* UPDPWeaponComponent::AcquireAudioComponent()
+{
+	const UPDPWeaponDefinition* WeaponDefinition = GetDefinition();
+
+	// Components are used in turn, so once the pool is full the next one is always the oldest sound.
+	if (AudioComponents.IsValidIndex(NextAudioComponent))
+	{
+		UAudioComponent* AudioComponent = AudioComponents[NextAudioComponent];
+		if (!AudioComponent->IsPlaying() || AudioComponents.Num() >= WeaponDefinition->MaxSoundsPerCharacter)
+		{
+			NextAudioComponent = (NextAudioComponent + 1) % AudioComponents.Num();
+			return AudioComponent;
+		}
+	}
+
+	AActor* Owner = GetOwner();
+	if (!Owner || !Owner->GetRootComponent())
+	{
+		return nullptr;
+	}
+
+	UAudioComponent* AudioComponent = NewObject<UAudioComponent>(Owner);
+	AudioComponent->bAutoActivate = false;
+	AudioComponent->bAutoDestroy = false;
+	AudioComponent->AttenuationSettings = WeaponDefinition->SoundAttenuation;
+	if (WeaponDefinition->SoundConcurrency)
+	{
+		AudioComponent->ConcurrencySet.Add(WeaponDefinition->SoundConcurrency);
+	}
+
+	AudioComponent->SetupAttachment(Owner->GetRootComponent());
+	AudioComponent->RegisterComponent();
+
+	AudioComponents.Add(AudioComponent);
+	return AudioComponent;
+}
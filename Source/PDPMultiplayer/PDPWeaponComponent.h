@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "PDPWeaponComponent.generated.h"
+
+class UAudioComponent;
+class UPDPWeaponDefinition;
+
+/**
+ * Weapon carried by a character. The tuning lives in a shared UPDPWeaponDefinition, the component only
+ * keeps the time of the last shot and compares it to the fire interval, so firing never sets a timer.
+ * Ammo is part of the replicated character state.
+ *
+ * Weapon sounds play on a few audio components kept by the weapon, reused shot after shot.
+ */
+UCLASS(ClassGroup=(PDP), meta=(BlueprintSpawnableComponent))
+class PDPMULTIPLAYER_API UPDPWeaponComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UPDPWeaponComponent();
+
+	/**
+	 * Returns whether the fire interval has elapsed since the last shot.
+	 * @param Tolerance	Seconds the shot may come early, on the server
+	 */
+	bool IsReadyToFire(float Tolerance = 0.0f) const;
+
+	/** Starts the next fire interval, from now or from the end of the previous one if the shot came early. */
+	void NotifyFired();
+
+	/** Lets the next shot go out right away. */
+	void ResetCooldown();
+
+	uint8 GetMaxAmmo() const;
+
+	/** Plays the shot, or the empty click, attached to the owner's root. */
+	void PlayFireSound(bool bDryFire);
+
+	/** Returns the definition set on the component, or the class defaults when there is none. Never null. */
+	const UPDPWeaponDefinition* GetDefinition() const;
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category= "Weapon")
+	UPDPWeaponDefinition* Definition;
+
+private:
+	/** Returns the next audio component in turn, adding one while the pool isn't full and the next one still plays. */
+	UAudioComponent* AcquireAudioComponent();
+
+	/** World time of the last shot. */
+	float LastFireTime = -MAX_FLT;
+
+	UPROPERTY(Transient)
+	TArray<UAudioComponent*> AudioComponents;
+
+	int32 NextAudioComponent = 0;
+};
@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PDPWeaponDefinition.h"
+
+#include "Sound/SoundAttenuation.h"
+#include "Sound/SoundBase.h"
+#include "Sound/SoundConcurrency.h"
+#include "UObject/ConstructorHelpers.h"
+
+UPDPWeaponDefinition::UPDPWeaponDefinition()
+{
+	// Sounds the character Blueprint used before the weapon had its own asset.
+	static ConstructorHelpers::FObjectFinder<USoundBase> ShotSoundFinder(TEXT("/Game/Audio/Sound_Shot"));
+	static ConstructorHelpers::FObjectFinder<USoundBase> NoAmmoSoundFinder(TEXT("/Game/Audio/Sound_NoAmmo"));
+	static ConstructorHelpers::FObjectFinder<USoundAttenuation> SoundAttenuationFinder(TEXT("/Game/Audio/SA_Weapon"));
+
+	ShotSound = ShotSoundFinder.Object;
+	NoAmmoSound = NoAmmoSoundFinder.Object;
+	SoundAttenuation = SoundAttenuationFinder.Object;
+
+	SoundConcurrency = CreateDefaultSubobject<USoundConcurrency>(TEXT("SoundConcurrency"));
+	SoundConcurrency->Concurrency.MaxCount = MaxConcurrentSounds;
+	SoundConcurrency->Concurrency.ResolutionRule = EMaxConcurrentResolutionRule::StopFarthestThenOldest;
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "PDPWeaponDefinition.generated.h"
+
+class USoundAttenuation;
+class USoundBase;
+class USoundConcurrency;
+
+/**
+ * Tuning of a weapon, shared by every character carrying it instead of being copied into each of them.
+ * The class defaults are the weapon of a character whose Weapon component has no definition set.
+ */
+UCLASS(BlueprintType)
+class PDPMULTIPLAYER_API UPDPWeaponDefinition : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPDPWeaponDefinition();
+
+	UPROPERTY(EditDefaultsOnly, Category= "Weapon", meta=(ClampMin = "0", ClampMax = "255"))
+	uint8 MaxAmmo = 30;
+
+	UPROPERTY(EditDefaultsOnly, Category= "Weapon", meta=(ClampMin = "0"))
+	float DamageAmount = 20.0f;
+
+	/** Minimum number of seconds between two shots. */
+	UPROPERTY(EditDefaultsOnly, Category= "Weapon", meta=(ClampMin = "0"))
+	float FireInterval = 0.2f;
+
+	/** How much sooner than FireInterval the server accepts a shot, for shots bunched up by network jitter. */
+	UPROPERTY(EditDefaultsOnly, Category= "Weapon", meta=(ClampMin = "0"))
+	float MaxFireIntervalError = 0.05f;
+
+	UPROPERTY(EditDefaultsOnly, Category= "Weapon", meta=(ClampMin = "0"))
+	float TraceDistance = 30000.0f;
+
+	/** How far the client trace start may be from the server camera before the server one is used instead. */
+	UPROPERTY(EditDefaultsOnly, Category= "Weapon", meta=(ClampMin = "0"))
+	float MaxTraceStartError = 200.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category= "SFX")
+	USoundBase* ShotSound = nullptr;
+
+	UPROPERTY(EditDefaultsOnly, Category= "SFX")
+	USoundBase* NoAmmoSound = nullptr;
+
+	UPROPERTY(EditDefaultsOnly, Category= "SFX")
+	USoundAttenuation* SoundAttenuation = nullptr;
+
+	/**
+	 * Caps the weapon sounds heard at once across all characters, beyond it the farthest or oldest are stolen.
+	 * Defaults to MaxConcurrentSounds voices with StopFarthestThenOldest.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category= "SFX")
+	USoundConcurrency* SoundConcurrency = nullptr;
+
+	static constexpr int32 MaxConcurrentSounds = 16;
+
+	/** Audio components each character keeps for this weapon. A new sound cuts the oldest one once they all play. */
+	UPROPERTY(EditDefaultsOnly, Category= "SFX", meta=(ClampMin = "1"))
+	int32 MaxSoundsPerCharacter = 3;
+};